@@ -0,0 +1,125 @@
+// Counts the heap allocations of the iterated local search. Every instance is solved with a single
+// search thread and a fixed seed for an increasing number of iterations, and each solve repeats the
+// previous one before going further, so the difference of two solves is the allocations of the
+// iterations in between. The scratch buffers of the search are kept by the thread across solves, so
+// a first solve of all iterations grows them and every counted solve starts from the same state.
+// Once the routes and caches have grown to their working sizes, the iterations should not allocate
+// at all. Every solve ends by rebuilding its best solution, so a difference may be off by the few
+// allocations of that rebuild, either way.
+//
+// A restart constructs a new solution, which allocates, and small instances restart every few
+// iterations. The stagnation limit is therefore lifted, so that all iterations run within the
+// restart of the setup row and the windows count the iterations alone.
+//
+// Usage: allocation_bench [--window <iterations>] [--windows <count>] <instance files>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../include/distance_matrix_optimizer.h"
+#include "../include/setup.h"
+#include "../include/solver.h"
+
+namespace
+{
+std::atomic<uint64_t> num_allocations{0};
+
+void *Allocate(std::size_t size)
+{
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *AllocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    std::size_t align = static_cast<std::size_t>(alignment);
+    if (void *pointer = std::aligned_alloc(align, (size + align - 1) / align * align))
+        return pointer;
+    throw std::bad_alloc();
+}
+}
+
+// Every form of new counts the allocation, and every form of delete frees it
+void *operator new(std::size_t size) { return Allocate(size); }
+void *operator new[](std::size_t size) { return Allocate(size); }
+void *operator new(std::size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+
+// Allocations of a solve of the given number of iterations
+uint64_t CountAllocations(const Problem &problem, uint64_t num_iterations)
+{
+    SpecificConfig config = MakeConfig(1);
+    config.time_limit = 0;
+    config.stopping_criteria.max_iterations = num_iterations;
+    config.max_stagnation = std::numeric_limits<int>::max(); // A single restart, see above
+    uint64_t start = num_allocations.load();
+    SpecificSolver().Solve(config, problem);
+    return num_allocations.load() - start;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t window = 100;
+    int num_windows = 5;
+    std::vector<std::string> problem_paths;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--window" && i + 1 < argc)
+            window = std::max(1, std::atoi(argv[++i]));
+        else if (argument == "--windows" && i + 1 < argc)
+            num_windows = std::max(1, std::atoi(argv[++i]));
+        else
+            problem_paths.push_back(argument);
+    }
+
+    if (problem_paths.empty())
+    {
+        std::cerr << "Usage: allocation_bench [--window <iterations>] [--windows <count>] <instance files>"
+                  << std::endl;
+        return 1;
+    }
+
+    for (const std::string &problem_path : problem_paths)
+    {
+        Problem problem = ReadProblemFromFile(problem_path);
+        DistanceMatrixOptimizer distance_matrix_optimizer(problem.distance_matrix);
+
+        std::cout << std::endl << problem_path << std::endl << std::left << std::setw(24) << "Iterations"
+                  << std::right << std::setw(16) << "Allocations" << std::setw(16) << "Per iteration" << std::endl;
+        CountAllocations(problem, num_windows * window + 1);
+        uint64_t previous = CountAllocations(problem, 1);
+        std::cout << std::left << std::setw(24) << "1 (setup)" << std::right << std::setw(16) << previous
+                  << std::endl;
+        for (int i = 0; i < num_windows; ++i)
+        {
+            uint64_t first = i * window + 2;
+            uint64_t last = (i + 1) * window + 1;
+            uint64_t allocations = CountAllocations(problem, last);
+            int64_t difference = static_cast<int64_t>(allocations) - static_cast<int64_t>(previous);
+            previous = allocations;
+            std::cout << std::left << std::setw(24) << std::to_string(first) + "-" + std::to_string(last)
+                      << std::right << std::setw(16) << difference << std::setw(16) << std::fixed
+                      << std::setprecision(2) << static_cast<double>(difference) / window << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,272 @@
+// Micro-benchmark of the operators and the building blocks of the perturbation. Every instance is
+// solved for a fixed number of iterations with a fixed seed, and each component is then timed in
+// isolation on copies of that frozen solution.
+//
+// Usage: operator_bench [--iterations <count>] [--min-time <seconds>] <instance files>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../include/base_star.h"
+#include "../include/distance_matrix_optimizer.h"
+#include "../include/random_engine.h"
+#include "../include/repair.h"
+#include "../include/setup.h"
+#include "../include/solver.h"
+#include "../include/split_reinsertion.h"
+#include "../include/utils.h"
+
+// Timed calls of one component and the moves they evaluated
+struct Measurement
+{
+    uint64_t calls = 0;
+    uint64_t moves = 0; // Zero if the component has no natural unit of work
+    uint64_t nanoseconds = 0;
+};
+
+// Time function as count calls
+template <class Function>
+void Time(Measurement &measurement, uint64_t count, Function function)
+{
+    auto start_time = std::chrono::steady_clock::now();
+    function();
+    measurement.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - start_time)
+                                   .count();
+    measurement.calls += count;
+}
+
+// Keep a result from being optimized away, without storing it
+inline void KeepResult(int value)
+{
+    asm volatile("" : : "r"(value));
+}
+
+// Repeat the repetition, which sets up untimed and times its calls with Time, for at least min_seconds
+template <class Repetition>
+Measurement Repeat(double min_seconds, Repetition repetition)
+{
+    Measurement measurement;
+    while (measurement.nanoseconds < min_seconds * 1e9)
+        repetition(measurement);
+    return measurement;
+}
+
+void PrintHeader()
+{
+    std::cout << std::left << std::setw(20) << "Component" << std::setw(8) << "Case" << std::right
+              << std::setw(14) << "ns/call" << std::setw(16) << "moves/s" << std::endl;
+}
+
+void Print(const std::string &component, const std::string &variant, const Measurement &measurement)
+{
+    std::cout << std::left << std::setw(20) << component << std::setw(8) << variant << std::right
+              << std::setw(14) << std::fixed << std::setprecision(0)
+              << static_cast<double>(measurement.nanoseconds) / measurement.calls << std::setw(16);
+    if (measurement.moves)
+        std::cout << std::scientific << std::setprecision(3) << measurement.moves * 1e9 / measurement.nanoseconds;
+    else
+        std::cout << "-";
+    std::cout << std::defaultfloat << std::endl;
+}
+
+// Route pairs evaluated by the inter-route caches of the map, the misses of their lookups
+uint64_t PairEvaluations(const CacheMap &cache_map)
+{
+    uint64_t misses = 0;
+    for (const CacheStatistics &cache : cache_map.Statistics())
+    {
+        if (cache.name.rfind("InterRouteCache", 0) == 0)
+            misses += cache.misses;
+    }
+    return misses;
+}
+
+// Insertion positions of every customer into every route, as scanned by a full preparation
+uint64_t InsertionPositions(const Problem &problem, const SpecificSolution &solution, const RouteContext &context)
+{
+    return static_cast<uint64_t>(problem.num_customers - 1) * (solution.NodeIndices().size() + context.NumRoutes());
+}
+
+void BenchmarkInstance(const std::string &problem_path, int num_iterations, double min_seconds)
+{
+    Problem problem = ReadProblemFromFile(problem_path);
+    DistanceMatrixOptimizer distance_matrix_optimizer(problem.distance_matrix);
+    SpecificConfig config = MakeConfig(1);
+    config.time_limit = 0;
+    config.stopping_criteria.max_iterations = num_iterations;
+    const SpecificSolution frozen = SpecificSolver().Solve(config, problem);
+
+    RouteContext frozen_context(problem);
+    frozen_context.CalcRouteContext(frozen);
+    NeighborLists neighbors(problem, config.granular_neighbors);
+    SearchContext search{neighbors};
+    Rankings rankings(problem, config.ruin_neighbors);
+    ThreadRandom().Seed(config.random_seed, 0);
+
+    std::cout << std::endl << problem_path << ": " << problem.num_customers - 1 << " customers, "
+              << frozen_context.NumRoutes() << " routes, objective " << frozen_context.Objective() << std::endl
+              << std::endl;
+    PrintHeader();
+
+    // The inter-operators only evaluate, so they run on the frozen solution. Cold calls start with new
+    // caches, as after a reset of the cache map. Warm calls find every route pair cached.
+    for (const auto &op : config.inter_operators)
+    {
+        Measurement cold = Repeat(min_seconds, [&](Measurement &measurement)
+        {
+            CacheMap cache_map;
+            Time(measurement, 1, [&]() { op->Evaluate(problem, frozen, frozen_context, cache_map, search); });
+            measurement.moves += PairEvaluations(cache_map);
+        });
+        Print(op->Name(), "cold", cold);
+
+        CacheMap cache_map;
+        op->Evaluate(problem, frozen, frozen_context, cache_map, search);
+        Measurement warm = Repeat(min_seconds, [&](Measurement &measurement)
+        {
+            Time(measurement, 1, [&]() { op->Evaluate(problem, frozen, frozen_context, cache_map, search); });
+        });
+        Print(op->Name(), "warm", warm);
+    }
+
+    // The intra-operators apply their moves, so every repetition searches each route of a copy once.
+    SpecificSolution solution;
+    RouteContext context(problem);
+    for (const auto &op : config.intra_operators)
+    {
+        Measurement measurement = Repeat(min_seconds, [&](Measurement &measurement)
+        {
+            solution = frozen;
+            context.CalcRouteContext(solution);
+            for (Node route_index = 0; route_index < context.NumRoutes(); ++route_index)
+                Time(measurement, 1, [&]() { (*op)(problem, route_index, solution, context); });
+        });
+        Print(op->Name(), "route", measurement);
+    }
+
+    // Calls are routes prepared or looked up, the moves are the insertion positions scanned
+    Measurement cold = Repeat(min_seconds, [&](Measurement &measurement)
+    {
+        StarCaches star_caches;
+        star_caches.Reset(frozen, frozen_context);
+        Time(measurement, frozen_context.NumRoutes(),
+             [&]() { star_caches.PreprocessAll(problem, frozen, frozen_context, nullptr, nullptr); });
+        measurement.moves += InsertionPositions(problem, frozen, frozen_context);
+    });
+    Print("StarCaches", "cold", cold);
+
+    StarCaches star_caches;
+    star_caches.Reset(frozen, frozen_context);
+    star_caches.PreprocessAll(problem, frozen, frozen_context, nullptr, nullptr);
+    Measurement warm = Repeat(min_seconds, [&](Measurement &measurement)
+    {
+        Time(measurement, frozen_context.NumRoutes(),
+             [&]() { star_caches.PreprocessAll(problem, frozen, frozen_context, nullptr, nullptr); });
+    });
+    Print("StarCaches", "warm", warm);
+
+    // Best insertion of every customer into every route, with the cost used by SplitReinsertion
+    auto insertion_cost = [&](Node predecessor, Node successor, Node customer)
+    {
+        Node predecessor_customer = frozen.Customer(predecessor);
+        Node successor_customer = frozen.Customer(successor);
+        return problem.distance_matrix(customer, predecessor_customer)
+               + problem.distance_matrix(customer, successor_customer)
+               - problem.distance_matrix(predecessor_customer, successor_customer);
+    };
+    Measurement insertion = Repeat(min_seconds, [&](Measurement &measurement)
+    {
+        int checksum = 0;
+        Time(measurement, static_cast<uint64_t>(problem.num_customers - 1) * frozen_context.NumRoutes(), [&]()
+        {
+            for (Node customer = 1; customer < problem.num_customers; ++customer)
+            {
+                for (Node route_index = 0; route_index < frozen_context.NumRoutes(); ++route_index)
+                    checksum += CalcBestInsertion(frozen, insertion_cost, frozen_context, route_index, customer)
+                                    .cost.value;
+            }
+        });
+        measurement.moves += InsertionPositions(problem, frozen, frozen_context);
+        KeepResult(checksum); // Keeps the insertions from being optimized away
+    });
+    Print("CalcBestInsertion", "route", insertion);
+
+    // The ruin only selects customers, so it runs on the frozen solution
+    RouteContext ruin_context(problem);
+    ruin_context.CalcRouteContext(frozen);
+    SpecificSolution ruin_solution = frozen;
+    std::vector<Node> customers;
+    Measurement ruin = Repeat(min_seconds, [&](Measurement &measurement)
+    {
+        Time(measurement, 1, [&]() { config.ruin_method->Ruin(problem, rankings, ruin_solution, ruin_context, customers); });
+    });
+    Print("SisrsRuin::Ruin", "call", ruin);
+
+    // Reinsert the customers of a ruin, removed from a copy as the perturbation does
+    config.ruin_method->Ruin(problem, rankings, ruin_solution, ruin_context, customers);
+    Measurement reinsertion = Repeat(min_seconds, [&](Measurement &measurement)
+    {
+        solution = frozen;
+        context.CalcRouteContext(solution);
+        for (Node customer : customers)
+        {
+            while (Node node_index = solution.FirstVisit(customer))
+                solution.Remove(node_index);
+        }
+        context.CalcRouteContext(solution);
+        for (Node customer : customers)
+        {
+            Time(measurement, 1, [&]()
+            {
+                SplitReinsertion(problem, customer, problem.demands[customer], config.blink_rate, solution,
+                                 context);
+            });
+        }
+    });
+    Print("SplitReinsertion", "call", reinsertion);
+
+    Measurement repair = Repeat(min_seconds, [&](Measurement &measurement)
+    {
+        solution = frozen;
+        context.CalcRouteContext(solution);
+        for (Node route_index = 0; route_index < context.NumRoutes(); ++route_index)
+            Time(measurement, 1, [&]() { Repair(problem, route_index, solution, context); });
+    });
+    Print("Repair", "route", repair);
+}
+
+int main(int argc, char **argv)
+{
+    int num_iterations = 100;
+    double min_seconds = 0.2;
+    std::vector<std::string> problem_paths;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--iterations" && i + 1 < argc)
+            num_iterations = std::max(1, std::atoi(argv[++i]));
+        else if (argument == "--min-time" && i + 1 < argc)
+            min_seconds = std::atof(argv[++i]);
+        else
+            problem_paths.push_back(argument);
+    }
+
+    if (problem_paths.empty())
+    {
+        std::cerr << "Usage: operator_bench [--iterations <count>] [--min-time <seconds>] <instance files>"
+                  << std::endl;
+        return 1;
+    }
+
+    for (const std::string &problem_path : problem_paths)
+        BenchmarkInstance(problem_path, num_iterations, min_seconds);
+    return 0;
+}
@@ -0,0 +1,365 @@
+// End-to-end benchmark of the solver. Every instance is solved with several seeds, and the time at
+// which each run first comes within 1%, 0.5% and 0.1% of a reference objective is taken from the
+// updates of the listener. The reference is the best-known objective from --reference if given,
+// then the reference of the baseline so both are measured alike, and otherwise the best final
+// objective of all runs of the instance.
+//
+// The runs are written as CSV. A summary of the median time-to-target and final gap per instance is
+// printed, and if a baseline CSV written by an earlier run is given, the instances whose medians got
+// worse are flagged and the exit code is 1.
+//
+// Usage: time_to_target [--seeds <count>] [--time-limit <seconds>] [--reference <csv>]
+//                       [--baseline <csv>] [--output <csv>] [--tolerance <fraction>] <instance files>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/distance_matrix_optimizer.h"
+#include "../include/setup.h"
+#include "../include/solver.h"
+
+const double kTargetGaps[] = {0.01, 0.005, 0.001}; // Gaps to the reference of the targets
+const double kNotReached = std::numeric_limits<double>::infinity();
+
+// Records the time of every improvement of a run
+class TrajectoryListener : public Listener
+{
+public:
+    explicit TrajectoryListener(std::vector<std::pair<double, int>> &updates) : updates_(updates) {}
+
+    void OnStart() override { start_time_ = std::chrono::steady_clock::now(); }
+    void OnUpdated([[maybe_unused]] const SpecificSolution &solution, int objective) override
+    {
+        updates_.emplace_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count(),
+                              objective);
+    }
+    void OnEnd([[maybe_unused]] const SpecificSolution &solution, [[maybe_unused]] int objective) override {}
+
+private:
+    std::vector<std::pair<double, int>> &updates_;
+    std::chrono::steady_clock::time_point start_time_;
+};
+
+// One solve of an instance
+struct Run
+{
+    std::string instance;
+    uint32_t seed = 0;
+    std::vector<std::pair<double, int>> updates; // Seconds and objective of every improvement
+    int final_objective = 0;
+    int reference = 0;
+    double times[std::size(kTargetGaps)]; // Seconds to reach each target, kNotReached if never
+
+    double FinalGap() const { return 100.0 * (final_objective - reference) / reference; }
+};
+
+// Per-instance medians over the runs
+struct Summary
+{
+    double times[std::size(kTargetGaps)];
+    double final_gap = 0; // Percent
+};
+
+// Median of the values, where kNotReached counts as the largest value
+double Median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+// Split a CSV line into fields
+std::vector<std::string> SplitFields(const std::string &line)
+{
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ','))
+        fields.push_back(field);
+    return fields;
+}
+
+// Read the columns of a CSV file with a header line, one map from column name to value per row
+std::vector<std::map<std::string, std::string>> ReadCsv(const std::string &path)
+{
+    std::ifstream ifs(path);
+    if (ifs.fail())
+        throw std::invalid_argument("Cannot open " + path + ".");
+
+    std::string line;
+    std::getline(ifs, line);
+    std::vector<std::string> header = SplitFields(line);
+    std::vector<std::map<std::string, std::string>> rows;
+    while (std::getline(ifs, line))
+    {
+        if (line.empty())
+            continue;
+        std::vector<std::string> fields = SplitFields(line);
+        auto &row = rows.emplace_back();
+        for (size_t i = 0; i < header.size() && i < fields.size(); ++i)
+            row[header[i]] = fields[i];
+    }
+    return rows;
+}
+
+std::string TimeColumn(size_t target)
+{
+    std::ostringstream name;
+    name << "time_to_" << kTargetGaps[target] * 100 << "%";
+    return name.str();
+}
+
+void WriteCsv(std::ostream &os, const std::vector<Run> &runs)
+{
+    os << "instance,seed,reference,final_objective,final_gap";
+    for (size_t target = 0; target < std::size(kTargetGaps); ++target)
+        os << ',' << TimeColumn(target);
+    os << std::endl;
+
+    for (const Run &run : runs)
+    {
+        os << run.instance << ',' << run.seed << ',' << run.reference << ',' << run.final_objective << ','
+           << run.FinalGap();
+        for (double time : run.times)
+        {
+            os << ',';
+            if (time != kNotReached)
+                os << time;
+        }
+        os << std::endl;
+    }
+}
+
+// Read the runs of a CSV written by WriteCsv
+std::vector<Run> ReadRuns(const std::string &path)
+{
+    std::vector<Run> runs;
+    for (auto &row : ReadCsv(path))
+    {
+        Run &run = runs.emplace_back();
+        run.instance = row["instance"];
+        run.seed = std::stoul(row["seed"]);
+        run.reference = std::stoi(row["reference"]);
+        run.final_objective = std::stoi(row["final_objective"]);
+        for (size_t target = 0; target < std::size(kTargetGaps); ++target)
+        {
+            const std::string &time = row[TimeColumn(target)];
+            run.times[target] = time.empty() ? kNotReached : std::stod(time);
+        }
+    }
+    return runs;
+}
+
+// Medians of the runs of every instance
+std::map<std::string, Summary> Summarize(const std::vector<Run> &runs)
+{
+    std::map<std::string, std::vector<const Run *>> instances;
+    for (const Run &run : runs)
+        instances[run.instance].push_back(&run);
+
+    std::map<std::string, Summary> summaries;
+    for (const auto &[instance, instance_runs] : instances)
+    {
+        Summary &summary = summaries[instance];
+        for (size_t target = 0; target < std::size(kTargetGaps); ++target)
+        {
+            std::vector<double> times;
+            for (const Run *run : instance_runs)
+                times.push_back(run->times[target]);
+            summary.times[target] = Median(times);
+        }
+        std::vector<double> gaps;
+        for (const Run *run : instance_runs)
+            gaps.push_back(run->FinalGap());
+        summary.final_gap = Median(gaps);
+    }
+    return summaries;
+}
+
+// Solve the instance once per seed
+std::vector<Run> SolveInstance(const std::string &problem_path, int num_seeds, double time_limit)
+{
+    Problem problem = ReadProblemFromFile(problem_path);
+    DistanceMatrixOptimizer distance_matrix_optimizer(problem.distance_matrix);
+
+    std::vector<Run> runs(num_seeds);
+    for (int i = 0; i < num_seeds; ++i)
+    {
+        Run &run = runs[i];
+        run.instance = std::filesystem::path(problem_path).stem().string();
+        SpecificConfig config = MakeConfig(1);
+        config.random_seed += i;
+        config.time_limit = time_limit;
+        config.listener = std::make_unique<TrajectoryListener>(run.updates);
+        run.seed = config.random_seed;
+        run.final_objective = SpecificSolver().Solve(config, problem).CalcObjective(problem);
+        std::cout << run.instance << " seed " << run.seed << ": " << run.final_objective << std::endl;
+    }
+    return runs;
+}
+
+// Set the reference of the runs of an instance and the times at which they reach the targets
+void MeasureTargets(std::vector<Run> &runs, const std::map<std::string, int> &references)
+{
+    int reference = std::numeric_limits<int>::max();
+    for (const Run &run : runs)
+        reference = std::min(reference, run.final_objective);
+    if (auto it = references.find(runs.front().instance); it != references.end())
+        reference = it->second;
+
+    for (Run &run : runs)
+    {
+        run.reference = reference;
+        for (size_t target = 0; target < std::size(kTargetGaps); ++target)
+        {
+            run.times[target] = kNotReached;
+            for (auto [time, objective] : run.updates)
+            {
+                if (objective <= reference * (1 + kTargetGaps[target]))
+                {
+                    run.times[target] = time;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+std::string FormatTime(double time)
+{
+    if (time == kNotReached)
+        return "-";
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(3) << time;
+    return os.str();
+}
+
+// Print the summary, compared with the baseline if there is one. Returns the number of regressions:
+// a median time-to-target slower by more than the tolerance, a target no longer reached, or a worse
+// median final gap.
+int PrintSummary(const std::map<std::string, Summary> &summaries, const std::map<std::string, Summary> &baseline,
+                 double tolerance)
+{
+    std::cout << std::endl << std::left << std::setw(12) << "Instance" << std::right;
+    for (size_t target = 0; target < std::size(kTargetGaps); ++target)
+        std::cout << std::setw(16) << TimeColumn(target);
+    std::cout << std::setw(12) << "final_gap" << "  Regressions" << std::endl;
+
+    int num_regressions = 0;
+    for (const auto &[instance, summary] : summaries)
+    {
+        std::cout << std::left << std::setw(12) << instance << std::right;
+        for (double time : summary.times)
+            std::cout << std::setw(16) << FormatTime(time);
+        std::cout << std::setw(11) << std::fixed << std::setprecision(3) << summary.final_gap << "%";
+
+        auto it = baseline.find(instance);
+        if (it == baseline.end())
+        {
+            std::cout << std::endl;
+            continue;
+        }
+
+        // Times below a few milliseconds are noise, so they only count once the target is missed
+        std::string regressions;
+        const Summary &old = it->second;
+        for (size_t target = 0; target < std::size(kTargetGaps); ++target)
+        {
+            double time = summary.times[target];
+            if (time > std::max(old.times[target] * (1 + tolerance), old.times[target] + 0.005))
+                regressions += "  " + TimeColumn(target) + " " + FormatTime(old.times[target]) + " -> "
+                               + FormatTime(time);
+        }
+        if (summary.final_gap > old.final_gap + 1e-9)
+        {
+            std::ostringstream gap;
+            gap << std::fixed << std::setprecision(3) << "  final_gap " << old.final_gap << "% -> "
+                << summary.final_gap << "%";
+            regressions += gap.str();
+        }
+        num_regressions += !regressions.empty();
+        std::cout << regressions << std::endl;
+    }
+    return num_regressions;
+}
+
+int main(int argc, char **argv)
+{
+    int num_seeds = 3;
+    double time_limit = 10;
+    double tolerance = 0.2;
+    std::string reference_path, baseline_path, output_path = "./output/time_to_target.csv";
+    std::vector<std::string> problem_paths;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--seeds" && i + 1 < argc)
+            num_seeds = std::max(1, std::atoi(argv[++i]));
+        else if (argument == "--time-limit" && i + 1 < argc)
+            time_limit = std::atof(argv[++i]);
+        else if (argument == "--reference" && i + 1 < argc)
+            reference_path = argv[++i];
+        else if (argument == "--baseline" && i + 1 < argc)
+            baseline_path = argv[++i];
+        else if (argument == "--output" && i + 1 < argc)
+            output_path = argv[++i];
+        else if (argument == "--tolerance" && i + 1 < argc)
+            tolerance = std::atof(argv[++i]);
+        else
+            problem_paths.push_back(argument);
+    }
+
+    if (problem_paths.empty())
+    {
+        std::cerr << "Usage: time_to_target [--seeds <count>] [--time-limit <seconds>] [--reference <csv>] "
+                     "[--baseline <csv>] [--output <csv>] [--tolerance <fraction>] <instance files>"
+                  << std::endl;
+        return 1;
+    }
+
+    // Best-known objectives, as lines "instance,objective" after a header
+    std::map<std::string, int> references;
+    if (!reference_path.empty())
+    {
+        for (auto &row : ReadCsv(reference_path))
+            references[row["instance"]] = std::stoi(row["objective"]);
+    }
+
+    std::vector<Run> baseline_runs;
+    if (!baseline_path.empty())
+        baseline_runs = ReadRuns(baseline_path);
+    for (const Run &run : baseline_runs)
+        references.emplace(run.instance, run.reference);
+
+    std::vector<Run> runs;
+    for (const std::string &problem_path : problem_paths)
+    {
+        std::vector<Run> instance_runs = SolveInstance(problem_path, num_seeds, time_limit);
+        MeasureTargets(instance_runs, references);
+        runs.insert(runs.end(), instance_runs.begin(), instance_runs.end());
+    }
+
+    std::ofstream ofs(output_path);
+    WriteCsv(ofs, runs);
+    std::cout << std::endl << "Runs written to " << output_path << std::endl;
+
+    std::map<std::string, Summary> baseline = Summarize(baseline_runs);
+    int num_regressions = PrintSummary(Summarize(runs), baseline, tolerance);
+    if (!baseline_path.empty())
+        std::cout << std::endl << num_regressions << " instances regressed against " << baseline_path << std::endl;
+    return num_regressions > 0;
+}
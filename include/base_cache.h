@@ -2,10 +2,16 @@
 #define BASE_CACHE_H
 
 #include <algorithm>
+#include <utility>
 #include <vector>
 #include "cache.h"
 #include "delta.h"
 #include "route_context.h"
+#include "stopping.h"
+#include "thread_pool.h"
+
+// Pairs of route indices
+using RoutePairs = std::vector<std::pair<Node, Node>>;
 
 // Generic base cache template
 template <class T> struct BaseCache {
@@ -24,53 +30,56 @@ template <class T> struct BaseCache {
   }
 };
 
-// Specialized inter-route cache for caching relationships between routes
+// Specialized inter-route cache for caching relationships between routes. Every route is mapped
+// to a slot, and the entries of all ordered slot pairs are kept in one flat array laid out as a
+// lower triangle: the two entries of the slots lo < hi sit next to each other at
+// (hi * (hi - 1) / 2 + lo) * 2. Adding slots only appends to the array, so it grows geometrically
+// without moving the existing entries to new indices.
 template <class T> class InterRouteCache : public Cache {
 public:
   // Resets the entire cache based on the solution and context
   void Reset([[maybe_unused]] const SpecificSolution &solution, const RouteContext &context) override {
-    max_index_ = context.NumRoutes(); // Initialize max index to the number of routes
-    matrix_.resize(context.NumRoutes()); // Resize the matrix
-    route_index_mappings_.resize(context.NumRoutes()); // Map each route to itself
-    route_pool_.clear(); // Clear active routes
-    unused_indices_.clear(); // Clear unused indices
-    for (Node i = 0; i < context.NumRoutes(); ++i) {
-      matrix_[i].resize(context.NumRoutes()); // Create a matrix row for each route
+    Node num_routes = context.NumRoutes();
+    Reserve(std::max<int>(2 * num_routes, 2)); // Leave room for the routes added by the operators
+    num_slots_ = num_routes;
+    route_index_mappings_.resize(num_routes);
+    unused_slots_.clear();
+    for (Node i = 0; i < num_routes; ++i) {
       route_index_mappings_[i] = i; // Map route index to itself
-      route_pool_.emplace_back(i); // Add route to active pool
-      for (Node j = 0; j < context.NumRoutes(); ++j) {
-        matrix_[i][j].invalidated = true; // Mark all entries as invalidated
-      }
+    }
+    std::size_t num_entries = static_cast<std::size_t>(num_routes) * (num_routes - 1);
+    for (std::size_t i = 0; i < num_entries; ++i) {
+      entries_[i].invalidated = true; // Mark all entries as invalidated
     }
   }
 
   // Adds a new route to the cache
   void AddRoute(Node route_index) override {
-    Node index;
-    if (unused_indices_.empty()) { // Check if there are unused slots
-      index = max_index_++; // Create a new index
-      route_index_mappings_.resize(max_index_); // Resize mapping
-      matrix_.resize(max_index_); // Resize matrix
-      for (Node i = 0; i < max_index_; ++i) {
-        matrix_[i].resize(max_index_); // Adjust all rows to new size
-      }
+    Node slot;
+    if (unused_slots_.empty()) { // Check if there are unused slots
+      slot = num_slots_++;
+      Reserve(num_slots_);
     } else {
-      index = unused_indices_.back(); // Reuse an unused index
-      unused_indices_.pop_back();
+      slot = unused_slots_.back(); // Reuse an unused slot
+      unused_slots_.pop_back();
     }
-    route_index_mappings_[route_index] = index; // Map the route
-    route_pool_.emplace_back(index); // Add to active routes
-    for (Node other : route_pool_) {
-      matrix_[index][other].invalidated = true; // Invalidate new connections
-      matrix_[other][index].invalidated = true; // Invalidate reverse connections
+    if (static_cast<std::size_t>(route_index) >= route_index_mappings_.size()) {
+      route_index_mappings_.resize(route_index + 1);
+    }
+    route_index_mappings_[route_index] = slot; // Map the route
+    // Invalidate the pairs with every other slot. Entries of unused slots are invalidated
+    // again when the slot is reused, so there is no need to track which slots are active.
+    for (Node other = 0; other < num_slots_; ++other) {
+      if (other != slot) {
+        entries_[Index(slot, other)].invalidated = true;
+        entries_[Index(other, slot)].invalidated = true;
+      }
     }
   }
 
   // Removes a route from the cache
   void RemoveRoute(Node route_index) override {
-    Node index = route_index_mappings_[route_index]; // Find mapped index
-    route_pool_.erase(std::find(route_pool_.begin(), route_pool_.end(), index)); // Remove from active routes
-    unused_indices_.emplace_back(index); // Add to unused slots
+    unused_slots_.emplace_back(route_index_mappings_[route_index]); // Add to unused slots
   }
 
   // Moves data from one route to another
@@ -84,15 +93,105 @@ public:
 
   // Accesses the cache for two specific routes
   BaseCache<T> &Get(Node route_a, Node route_b) {
-    return matrix_[route_index_mappings_[route_a]][route_index_mappings_[route_b]];
+    return entries_[Index(route_index_mappings_[route_a], route_index_mappings_[route_b])];
+  }
+
+  // Attempts to reuse an entry of this cache, counting the lookup unless ClaimInvalidated already
+  // counted the lookups of this evaluation
+  bool TryReuse(BaseCache<T> &entry, bool count = true) {
+    bool reused = entry.TryReuse();
+    if (count) {
+      ++(reused ? hits_ : misses_);
+    }
+    return reused;
+  }
+
+  // Hits and misses of TryReuse
+  CacheStatistics Lookups() const override { return {"", hits_, misses_}; }
+
+  // Best move of the last evaluation, applied from here if the caller chooses it
+  T best_move{};
+
+  // Claims the invalidated entries of the route pairs (x, y) with y > x, or y != x if ordered, and
+  // returns the pairs accepted by select. Pairs that are not selected keep an empty entry. Every
+  // lookup is counted here, so the operator looks the entries up again without counting.
+  template <class Select> const RoutePairs &ClaimInvalidated(Node num_routes, bool ordered, Select select) {
+    claimed_.clear();
+    for (Node route_x = 0; route_x < num_routes; ++route_x) {
+      for (Node route_y = ordered ? 0 : route_x + 1; route_y < num_routes; ++route_y) {
+        if (route_x == route_y || TryReuse(Get(route_x, route_y))) {
+          continue;
+        }
+        if (select(route_x, route_y)) {
+          claimed_.emplace_back(route_x, route_y);
+        }
+      }
+    }
+    return claimed_;
   }
 
 private:
-  std::vector<std::vector<BaseCache<T>>> matrix_; // Cache matrix
-  std::vector<Node> route_index_mappings_; // Maps route indices to internal indices
-  std::vector<Node> route_pool_; // Active route indices
-  std::vector<Node> unused_indices_; // Unused slots
-  Node max_index_{}; // Max index for new routes
+  // Position of the entry of the ordered pair of distinct slots (a, b)
+  static std::size_t Index(Node a, Node b) {
+    std::size_t hi = std::max(a, b);
+    std::size_t lo = std::min(a, b);
+    return (hi * (hi - 1) / 2 + lo) * 2 + (a > b);
+  }
+
+  // Makes room for the pairs of the given number of slots, doubling the capacity when needed
+  void Reserve(Node num_slots) {
+    if (num_slots <= capacity_) {
+      return;
+    }
+    capacity_ = std::max<int>(num_slots, 2 * capacity_);
+    entries_.resize(static_cast<std::size_t>(capacity_) * (capacity_ - 1));
+  }
+
+  std::vector<BaseCache<T>> entries_; // Entries of all ordered slot pairs
+  std::vector<Node> route_index_mappings_; // Maps route indices to slots
+  std::vector<Node> unused_slots_; // Free list of slots
+  RoutePairs claimed_; // Pairs returned by ClaimInvalidated
+  Node num_slots_{}; // Slots handed out so far, used or unused
+  Node capacity_{}; // Number of slots the entries have room for
+  uint64_t hits_ = 0; // Lookups that reused an entry
+  uint64_t misses_ = 0; // Lookups of invalidated entries
 };
 
+// Evaluates the invalidated entries of the route pairs selected by select on the pool, calling
+// prepare with the claimed pairs first. The callers then find every entry valid, so the search
+// itself proceeds as if the entries had been evaluated sequentially. Once the search is cancelled,
+// if stopping is set, the remaining pairs are left invalidated instead.
+template <class T, class Select, class Prepare, class Evaluate>
+void EvaluateInvalidatedPairs(ThreadPool &pool, const StoppingCondition *stopping, InterRouteCache<T> &caches,
+                              Node num_routes, bool ordered, Select select, Prepare prepare,
+                              Evaluate evaluate) {
+  const RoutePairs &pairs = caches.ClaimInvalidated(num_routes, ordered, select);
+  if (pairs.empty()) {
+    return;
+  }
+  // Cancellation is final, so pairs prepared after it are never evaluated either
+  auto cancelled = [stopping] { return stopping && stopping->IsCancelled(); };
+  if (!cancelled()) {
+    prepare(pairs);
+  }
+  DeterministicParallelFor(pool, pairs.size(), [&](size_t i) {
+    auto [route_x, route_y] = pairs[i];
+    auto &entry = caches.Get(route_x, route_y);
+    if (cancelled()) {
+      entry.invalidated = true;
+      return;
+    }
+    evaluate(route_x, route_y, entry);
+  });
+}
+
+// Evaluates the invalidated entries of all route pairs on the pool
+template <class T, class Evaluate>
+void EvaluateInvalidatedPairs(ThreadPool &pool, const StoppingCondition *stopping, InterRouteCache<T> &caches,
+                              Node num_routes, bool ordered, Evaluate evaluate) {
+  EvaluateInvalidatedPairs(
+      pool, stopping, caches, num_routes, ordered, [](Node, Node) { return true; },
+      [](const RoutePairs &) {}, evaluate);
+}
+
 #endif
@@ -2,8 +2,10 @@
 #define BASE_STAR_H
 
 #include "inter_operator.h"
+#include <atomic>
 #include <limits>
 #include "base_cache.h"
+#include "insertion_kernel.h"
 
 // Represents an insertion with delta and its position
 struct Insertion {
@@ -35,7 +37,7 @@ template <int num> struct BestInsertion {
         insertions[i] = {{delta, 1}, predecessor, successor};
         return;
       } else if (delta == insertions[i].delta.value && insertions[i].delta.counter != -1) {
-        if ((rand() % (insertions[i].delta.counter + 1) + 1) == 1) {
+        if (ThreadRandom().Below(insertions[i].delta.counter + 1) == 0) {
           for (int j = num - 1; j > i; --j) {
             insertions[j] = insertions[j - 1];
           }
@@ -53,6 +55,16 @@ template <int num> struct BestInsertion {
   // Finds the best insertion
   const Insertion *FindBest() const { return insertions; }
 
+  // Finds the best insertion satisfying a predicate
+  template <class Predicate> const Insertion *FindBestIf(Predicate predicate) const {
+    for (auto &insertion : insertions) {
+      if (insertion.delta.counter > 0 && predicate(insertion)) {
+        return &insertion;
+      }
+    }
+    return nullptr;
+  }
+
   // Finds the best insertion without a specific node
   const Insertion *FindBestWithoutNode(Node node_index) const {
     for (auto &insertion : insertions) {
@@ -68,14 +80,15 @@ template <int num> struct BestInsertion {
 // Manages star-related caches
 class StarCaches : public Cache {
 public:
-  // Resets caches based on solution and context
+  // Resets caches based on solution and context. The caches and saved routes only grow, so the
+  // memory of routes that are gone is reused by later ones.
   void Reset(const SpecificSolution &solution, const RouteContext &context) {
-    caches_.resize(context.NumRoutes());
-    for (Node route_index = 0;
-          static_cast<size_t>(route_index) < std::min(routes_.size(), caches_.size());
-          ++route_index) {
+    if (caches_.size() < static_cast<size_t>(context.NumRoutes())) {
+      caches_.resize(context.NumRoutes());
+    }
+    for (Node route_index = 0; static_cast<size_t>(route_index) < caches_.size(); ++route_index) {
       bool same_route = false;
-      if (route_index < context.NumRoutes()) {
+      if (route_index < context.NumRoutes() && route_index < num_saved_routes_) {
         same_route = true;
         Node head = context.Head(route_index);
         for (Node node : routes_[route_index]) {
@@ -95,8 +108,12 @@ public:
     }
   }
 
-  // Adds a route
-  void AddRoute(Node route_index) override { caches_.resize(route_index + 1); }
+  // Adds a route, whose cache past the other routes is empty
+  void AddRoute(Node route_index) override {
+    if (caches_.size() <= static_cast<size_t>(route_index)) {
+      caches_.resize(route_index + 1);
+    }
+  }
 
   // Removes a route
   void RemoveRoute(Node route_index) override { caches_[route_index].clear(); }
@@ -111,23 +128,35 @@ public:
                   Node route) {
     auto &&insertions = caches_[route];
     if (!insertions.empty()) {
+      hits_.fetch_add(1, std::memory_order_relaxed);
       return;
     }
+    misses_.fetch_add(1, std::memory_order_relaxed);
     insertions.resize(problem.num_customers);
     for (Node customer = 1; customer < problem.num_customers; ++customer) {
       insertions[customer].Reset();
     }
+    // Add only changes an insertion if the delta does not exceed its third best, so the
+    // vectorized scan filters the customers against these values kept in a flat array.
+    // The scratch arrays are per thread, as routes may be prepared in parallel.
+    static thread_local std::vector<int> thresholds;
+    static thread_local std::vector<Node> candidate_customers;
+    static thread_local std::vector<int> candidate_deltas;
+    thresholds.assign(problem.num_customers, std::numeric_limits<int>::max());
+    candidate_customers.resize(problem.num_customers);
+    candidate_deltas.resize(problem.num_customers);
     Node predecessor = 0;
     Node successor = context.Head(route);
     while (true) {
-      Node predecessor_customer = solution.Customer(predecessor);
-      Node successor_customer = solution.Customer(successor);
-      auto &&predecessor_distances = problem.distance_matrix[predecessor_customer];
-      auto &&successor_distances = problem.distance_matrix[successor_customer];
-      auto distance = problem.distance_matrix[predecessor_customer][successor_customer];
-      for (Node customer = 1; customer < problem.num_customers; ++customer) {
-        int delta = predecessor_distances[customer] + successor_distances[customer] - distance;
-        insertions[customer].Add(delta, predecessor, successor);
+      int num_candidates = CollectInsertionCandidates(
+          problem.distance_matrix, solution.Customer(predecessor), solution.Customer(successor),
+          problem.num_customers, thresholds.data(), candidate_customers.data(),
+          candidate_deltas.data());
+      for (int i = 0; i < num_candidates; ++i) {
+        Node customer = candidate_customers[i];
+        auto &best = insertions[customer];
+        best.Add(candidate_deltas[i], predecessor, successor);
+        thresholds[customer] = best.insertions[2].delta.value;
       }
       if (!successor) {
         break;
@@ -137,10 +166,53 @@ public:
     }
   }
 
+  // Prepares the caches of both routes of every pair on the pool. The caches of different routes
+  // are independent, and each route draws its random tie-breaks from its own stream.
+  void Preprocess(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                  const RoutePairs &pairs, ThreadPool &pool, const StoppingCondition *stopping) {
+    pending_routes_.clear();
+    for (auto [route_x, route_y] : pairs) {
+      for (Node route : {route_x, route_y}) {
+        if (caches_[route].empty()) {
+          pending_routes_.push_back(route);
+        }
+      }
+    }
+    std::sort(pending_routes_.begin(), pending_routes_.end());
+    pending_routes_.erase(std::unique(pending_routes_.begin(), pending_routes_.end()),
+                          pending_routes_.end());
+    PreprocessPending(problem, solution, context, pool, stopping);
+  }
+
+  // Prepares the caches of all routes, on the pool if there is one. Routes left when the search is
+  // cancelled stay unprepared, Preprocess prepares them if the caller still needs them.
+  void PreprocessAll(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                     ThreadPool *pool, const StoppingCondition *stopping) {
+    if (!pool) {
+      for (Node route = 0; route < context.NumRoutes(); ++route) {
+        if (stopping && stopping->IsCancelled()) {
+          return;
+        }
+        Preprocess(problem, solution, context, route);
+      }
+      return;
+    }
+    pending_routes_.clear();
+    for (Node route = 0; route < context.NumRoutes(); ++route) {
+      if (caches_[route].empty()) {
+        pending_routes_.push_back(route);
+      }
+    }
+    PreprocessPending(problem, solution, context, *pool, stopping);
+  }
+
   // Saves routes from solution and context
   void Save(const SpecificSolution &solution, const RouteContext &context) {
-    routes_.resize(context.NumRoutes());
-    for (Node route_index = 0; static_cast<size_t>(route_index) < routes_.size(); ++route_index) {
+    num_saved_routes_ = context.NumRoutes();
+    if (routes_.size() < static_cast<size_t>(num_saved_routes_)) {
+      routes_.resize(num_saved_routes_);
+    }
+    for (Node route_index = 0; route_index < num_saved_routes_; ++route_index) {
       auto &route = routes_[route_index];
       route.clear();
       for (Node node = context.Head(route_index); node; node = solution.Successor(node)) {
@@ -149,22 +221,41 @@ public:
     }
   }
 
+  // Calls of Preprocess that found the route prepared or had to prepare it
+  CacheStatistics Lookups() const override {
+    return {"", hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed)};
+  }
+
   // Gets the best insertion for a route and customer
   BestInsertion<3> &Get(Node route_index, Node customer) {
     return caches_[route_index][customer];
   }
 
 private:
+  // Prepares the caches of the pending routes on the pool
+  void PreprocessPending(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                         ThreadPool &pool, const StoppingCondition *stopping) {
+    DeterministicParallelFor(pool, pending_routes_.size(), [&](size_t i) {
+      if (!stopping || !stopping->IsCancelled()) {
+        Preprocess(problem, solution, context, pending_routes_[i]);
+      }
+    });
+  }
+
   std::vector<std::vector<BestInsertion<3>>> caches_; // Route caches
-  std::vector<std::vector<Node>> routes_; // Routes data
+  std::vector<std::vector<Node>> routes_; // Routes data, of which the first num_saved_routes_ are saved
+  Node num_saved_routes_{}; // Routes of the last Save
+  std::vector<Node> pending_routes_; // Routes prepared by the parallel Preprocess
+  std::atomic<uint64_t> hits_{0}; // Preprocess calls on prepared routes, counted from any thread
+  std::atomic<uint64_t> misses_{0}; // Preprocess calls that prepared a route
 };
 
 // Calculates delta for inserting a node
 inline int CalcDelta(const Problem &problem, const SpecificSolution &solution, Node node_index,
                       Node predecessor, Node successor) {
-  return problem.distance_matrix[solution.Customer(node_index)][solution.Customer(predecessor)]
-          + problem.distance_matrix[solution.Customer(node_index)][solution.Customer(successor)]
-          - problem.distance_matrix[solution.Customer(predecessor)][solution.Customer(successor)];
+  return problem.distance_matrix(solution.Customer(node_index), solution.Customer(predecessor))
+          + problem.distance_matrix(solution.Customer(node_index), solution.Customer(successor))
+          - problem.distance_matrix(solution.Customer(predecessor), solution.Customer(successor));
 }
 
 #endif
@@ -4,12 +4,13 @@
 #include "problem.h"
 #include "solution.h"
 
+#include <atomic>
 #include <memory>
-#include <typeindex>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "route_context.h"
+#include "statistics.h"
 
 using namespace std;
 
@@ -33,9 +34,13 @@ public:
 
     // Save the cache state
     virtual void Save(const SpecificSolution &solution, const RouteContext &context) = 0;
+
+    // Hits and misses of the lookups, zero if the cache does not count them
+    virtual CacheStatistics Lookups() const { return {}; }
 };
 
-// Handles multiple caches of different types
+// Handles multiple caches of different types. Every cache type gets a fixed slot the first
+// time it is named, so Get is an indexed load and the caches are visited without hashing.
 class CacheMap : public Cache
 {
 public:
@@ -43,22 +48,24 @@ public:
     template <class T>
     T &Get(const SpecificSolution &solution, const RouteContext &context)
     {
-        auto it = caches_.find(typeid(T));
-        if (it == caches_.end())
+        size_t slot = kSlot<T>;
+        if (slot >= slots_.size())
+            slots_.resize(slot + 1);
+
+        auto &cache = slots_[slot];
+        if (cache == nullptr)
         {
-            auto cache = make_unique<T>();
+            cache = make_unique<T>();
             cache->Reset(solution, context);
-            auto &cache_ref = *cache;
-            caches_.emplace(typeid(T), move(cache));
-            return cache_ref;
+            caches_.push_back(cache.get());
         }
-        return *static_cast<T *>(it->second.get());
+        return *static_cast<T *>(cache.get());
     }
 
     // Reset all caches
     void Reset(const SpecificSolution &solution, const RouteContext &context) override
     {
-        for (auto &[_, cache] : caches_)
+        for (Cache *cache : caches_)
         {
             cache->Reset(solution, context);
         }
@@ -67,7 +74,7 @@ public:
     // Add a route to all caches
     void AddRoute(Node route_index) override
     {
-        for (auto &[_, cache] : caches_)
+        for (Cache *cache : caches_)
         {
             cache->AddRoute(route_index);
         }
@@ -76,7 +83,7 @@ public:
     // Remove a route from all caches
     void RemoveRoute(Node route_index) override
     {
-        for (auto &[_, cache] : caches_)
+        for (Cache *cache : caches_)
         {
             cache->RemoveRoute(route_index);
         }
@@ -85,7 +92,7 @@ public:
     // Move a route in all caches
     void MoveRoute(Node dest_route_index, Node src_route_index) override
     {
-        for (auto &[_, cache] : caches_)
+        for (Cache *cache : caches_)
         {
             cache->MoveRoute(dest_route_index, src_route_index);
         }
@@ -94,14 +101,39 @@ public:
     // Save all caches
     void Save(const SpecificSolution &solution, const RouteContext &context) override
     {
-        for (auto &[_, cache] : caches_)
+        for (Cache *cache : caches_)
         {
             cache->Save(solution, context);
         }
     }
 
+    // Lookups of every created cache that counts them, named after the cache type
+    vector<CacheStatistics> Statistics() const
+    {
+        vector<CacheStatistics> statistics;
+        for (Cache *cache : caches_)
+        {
+            CacheStatistics lookups = cache->Lookups();
+            if (lookups.hits + lookups.misses == 0)
+                continue;
+            lookups.name = TypeName(typeid(*cache));
+            statistics.push_back(std::move(lookups));
+        }
+        return statistics;
+    }
+
 private:
-    unordered_map<type_index, unique_ptr<Cache>> caches_; // Stores caches by type
+    // Hand out the next free slot. Slots are assigned during static initialization.
+    static size_t NextSlot()
+    {
+        static atomic<size_t> next_slot{0};
+        return next_slot++;
+    }
+
+    template <class T> static inline const size_t kSlot = NextSlot(); // Slot of the cache type T
+
+    vector<unique_ptr<Cache>> slots_; // Caches by slot, null until first used
+    vector<Cache *> caches_; // Created caches, in creation order
 };
 
 #endif
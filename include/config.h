@@ -6,6 +6,8 @@
 #include "intra_operator.h"
 #include "ruin_method.h"
 #include "sorter.h"
+#include "stopping.h"
+#include "tracer.h"
 
 #include <functional>
 #include <memory>
@@ -19,13 +21,18 @@ public:
     virtual void OnStart() = 0;
     virtual void OnUpdated(const SpecificSolution &solution, int objective) = 0;
     virtual void OnEnd(const SpecificSolution &solution, int objective) = 0;
+
+    // Called before OnEnd with the statistics of the search, if they were collected
+    virtual void OnStatistics([[maybe_unused]] const SearchStatistics &statistics) {}
 };
 
 struct Config 
 {
     uint32_t random_seed; /**< The random seed for the optimization process. */
-    double time_limit;    /**< The time limit (in seconds) for the optimization process. */
+    double time_limit;    /**< The time limit (in seconds) for the optimization process, 0 for none. */
     std::unique_ptr<Listener> listener; /**< The listener for receiving optimization events. */
+    StoppingCriteria stopping_criteria; /**< Further limits of the optimization process, combined with the time limit. */
+    const CancellationToken *cancellation = nullptr; /**< Stops the optimization process once cancelled by another thread, if set. */
 };
 
 struct SpecificConfig : public Config 
@@ -40,6 +47,16 @@ struct SpecificConfig : public Config
     std::unique_ptr<RuinMethod>
         ruin_method;       /**< The ruin method for destroying parts of the solution. */
     Sorter sorter; /**< The sorter for sorting customers during the perturbation process. */
+    int num_threads = 1; /**< The number of threads running independent restarts. */
+    bool check_objective = false; /**< Cross-check the tracked objective against a full recalculation. */
+    int granular_neighbors = 0; /**< Nearest customers each inter-route move must connect to, 0 for full neighborhoods. */
+    int ruin_neighbors = 0; /**< Nearest customers ranked for every seed of the ruin, 0 to rank all customers. */
+    int num_evaluation_threads = 1; /**< The number of threads searching the routes and route pairs of each search thread. */
+    bool collect_statistics = false; /**< Time and count the operator calls and cache lookups, reported to the listener. */
+    Tracer *tracer = nullptr; /**< Records the phases of the search for a Chrome trace if set, owned by the caller. */
+    bool concurrent_operators = false; /**< Evaluate all inter-operators on the same solution in the RVND and apply the best improving move, instead of the first operator that improves. */
+    int num_trials = 1; /**< The number of perturbations of the accepted solution tried concurrently per iteration, each on its own thread. Above one, num_evaluation_threads is not used. */
+    int max_stagnation = 0; /**< Iterations without improvement before a search thread restarts from a new solution, 0 for a limit derived from the instance. */
 };
 
 #endif
\ No newline at end of file
@@ -1,7 +1,7 @@
 #ifndef DELTA_H
 #define DELTA_H
 
-#include <random>
+#include "random_engine.h"
 
 // To keep track of the best solution found so far
 // Returns true if value was updated, false otherwise
@@ -29,7 +29,7 @@ template <class T> struct Delta
         else if (new_value == value && counter != -1)
         {
             ++counter;
-            return ((rand() % counter + 1) == 1);
+            return ThreadRandom().Below(counter) == 0;
         }
 
         return false;
@@ -50,7 +50,7 @@ template <class T> struct Delta
         else if (delta.value == value && counter != -1) 
         {
             counter += delta.counter;
-            return (rand() % counter + 1) <= delta.counter;
+            return ThreadRandom().Below(counter) < static_cast<uint32_t>(delta.counter);
         }
         
         return false;
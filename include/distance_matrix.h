@@ -0,0 +1,80 @@
+#ifndef DISTANCE_MATRIX_H
+#define DISTANCE_MATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Allocator returning cache-line aligned memory
+template <class T> struct CacheAlignedAllocator
+{
+    using value_type = T;
+    static constexpr std::size_t kAlignment = 64;
+
+    CacheAlignedAllocator() = default;
+    template <class U> CacheAlignedAllocator(const CacheAlignedAllocator<U> &) {}
+
+    T *allocate(std::size_t n)
+    {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(kAlignment)));
+    }
+
+    void deallocate(T *pointer, std::size_t) { ::operator delete(pointer, std::align_val_t(kAlignment)); }
+
+    template <class U> bool operator==(const CacheAlignedAllocator<U> &) const { return true; }
+    template <class U> bool operator!=(const CacheAlignedAllocator<U> &) const { return false; }
+};
+
+// Distance matrix stored in a single cache-line aligned block. Distances are kept in 16 bits when
+// all of them fit, otherwise in 32 bits. A symmetric matrix can be stored as its upper triangle.
+class DistanceMatrix
+{
+public:
+    DistanceMatrix() = default;
+
+    // Build the matrix from a square matrix of distances
+    explicit DistanceMatrix(const std::vector<std::vector<int>> &distances, bool upper_triangle = false);
+
+    // Distance between i and j. Elements of either width are read with a single 32-bit load and
+    // masked, so the access does not branch on the storage width.
+    int operator()(int i, int j) const
+    {
+        uint32_t value;
+        std::memcpy(&value, data_.data() + (Offset(i, j) << shift_), sizeof(value));
+        return static_cast<int>(value & mask_);
+    }
+
+    // Set the distance between i and j. In the upper triangle layout this also sets (j, i).
+    void Set(int i, int j, int distance);
+
+    int Size() const { return size_; }
+    bool IsNarrow() const { return shift_ == 1; }
+    bool IsUpperTriangle() const { return upper_triangle_; }
+
+    // Contiguous row of the full layout, to be used by vectorized kernels
+    const uint16_t *NarrowRow(int i) const { return reinterpret_cast<const uint16_t *>(Row(i)); }
+    const int32_t *WideRow(int i) const { return reinterpret_cast<const int32_t *>(Row(i)); }
+
+private:
+    size_t Offset(int i, int j) const
+    {
+        if (!upper_triangle_) return static_cast<size_t>(i) * stride_ + j;
+        if (i > j) std::swap(i, j);
+        return row_offsets_[i] + j;
+    }
+
+    const unsigned char *Row(int i) const { return data_.data() + (static_cast<size_t>(i) * stride_ << shift_); }
+
+    int size_ = 0; // Number of rows and columns
+    size_t stride_ = 0; // Elements per row of the full layout, padded to a cache line
+    bool upper_triangle_ = false; // Whether only the upper triangle is stored
+    int shift_ = 2; // log2 of the element size
+    uint32_t mask_ = 0xffffffffu; // Mask selecting the element from a 32-bit load
+    std::vector<size_t> row_offsets_; // Offset of element (i, 0) in the upper triangle layout
+    std::vector<unsigned char, CacheAlignedAllocator<unsigned char>> data_; // Distances
+};
+
+#endif
@@ -10,7 +10,7 @@
 // Also keeps track of intermediate nodes for path restoration.
 class DistanceMatrixOptimizer{
 public:
-    explicit DistanceMatrixOptimizer(std::vector<std::vector<int>> &distance_matrix);
+    explicit DistanceMatrixOptimizer(DistanceMatrix &distance_matrix);
     // Restores all paths for the given solution
     void Restore(SpecificSolution &solution) const;
 
@@ -18,7 +18,7 @@ private:
     // Recursively restores the shortest path between nodes i and j
     void Restore(SpecificSolution &solution, Node i, Node j) const;
     
-    std::vector<std::vector<int>> original_;
+    DistanceMatrix original_;
     std::vector<std::vector<Node>> previous_node_indices_;
 };
 
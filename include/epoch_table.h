@@ -0,0 +1,60 @@
+#ifndef EPOCH_TABLE_H
+#define EPOCH_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Flat table indexed by small keys such as customers. Every entry is stamped with the epoch it was
+// written in, so the whole table is cleared in constant time by starting a new epoch.
+template <class T> class EpochTable
+{
+public:
+    // Clear the table and make room for keys below size
+    void Reset(size_t size)
+    {
+        if (values_.size() < size)
+        {
+            values_.resize(size);
+            stamps_.resize(size);
+        }
+        if (++epoch_ == 0)
+        {
+            // The stamps wrapped around, so the old ones could pass for the new epoch
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            epoch_ = 1;
+        }
+    }
+
+    // Whether the key was written since the last reset
+    bool Contains(size_t key) const { return stamps_[key] == epoch_; }
+
+    // Write the value-initialized entry of a key, returning whether it was not written since the
+    // last reset. A table of flags used as a set only inserts.
+    bool Insert(size_t key)
+    {
+        if (Contains(key))
+            return false;
+        stamps_[key] = epoch_;
+        values_[key] = T();
+        return true;
+    }
+
+    // Entry of a key, value-initialized if it was not written since the last reset
+    T &operator[](size_t key)
+    {
+        if (stamps_[key] != epoch_)
+        {
+            stamps_[key] = epoch_;
+            values_[key] = T();
+        }
+        return values_[key];
+    }
+
+private:
+    std::vector<T> values_;
+    std::vector<uint32_t> stamps_; // Epoch of the last write of every entry
+    uint32_t epoch_ = 0;
+};
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef INSERTION_KERNEL_H
+#define INSERTION_KERNEL_H
+
+#include "problem.h"
+
+/* Scans every customer c in [1, num_customers) for the insertion between the customers
+   predecessor and successor, whose delta is d(predecessor, c) + d(successor, c) - d(predecessor, successor).
+   Customers whose delta does not exceed thresholds[c] are written to customers/deltas in increasing
+   order and their number is returned. The scan is vectorized with AVX2 or AVX-512 when the CPU
+   supports it and the distance matrix uses the full layout. */
+int CollectInsertionCandidates(const DistanceMatrix &distance_matrix, Node predecessor, Node successor,
+                               Node num_customers, const int *thresholds, Node *customers, int *deltas);
+
+#endif
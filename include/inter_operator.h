@@ -5,40 +5,185 @@
 #include "solution.h"
 #include "route_context.h"
 #include "cache.h"
+#include "neighbor_lists.h"
+#include "statistics.h"
+#include "stopping.h"
+#include "delta.h"
+#include "epoch_table.h"
+#include "thread_pool.h"
+#include <array>
+#include <functional>
+#include <initializer_list>
+#include <string>
 #include <vector>
 
+  // Shared state of a local search passed to the inter-operators
+  struct SearchContext {
+    const NeighborLists &neighbors; // Granular neighborhoods restricting the moves
+    ThreadPool *pool = nullptr; // Pool evaluating the route pairs in parallel, sequential if null
+    StatisticsRecorder *statistics = nullptr; // Records the operator calls, if statistics are collected
+    StoppingCondition *stopping = nullptr; // Counts the operator calls and tells when to stop, if set
+
+    // Whether the search was cancelled or ran out of time. The operators check it between route pairs
+    // and return no move once it is.
+    bool IsCancelled() const { return stopping && stopping->IsCancelled(); }
+  };
+
+  // Calls visit with every node of a route whose customer forms a granular edge with the customer.
+  // The operators start from these nodes to enumerate only the moves of granular neighborhoods.
+  template <class Visit>
+  void ForEachNeighborVisit(const SpecificSolution &solution, const RouteContext &context,
+                            const NeighborLists &neighbors, Node customer, Node route_index, Visit visit) {
+    for (Node neighbor : neighbors.Neighbors(customer)) {
+      for (Node node_index = solution.FirstVisit(neighbor); node_index; node_index = solution.NextVisit(node_index)) {
+        if (context.RouteIndex(node_index) == route_index) {
+          visit(node_index);
+        }
+      }
+    }
+  }
+
+  // Nodes of a route scanned for the cost of visiting one neighbor in a granular enumeration
+  constexpr size_t kNeighborScanCost = 2;
+
+  // Whether the moves with a route of the given length are enumerated from the neighbor lists of the
+  // customers. The lists pay off only on routes longer than them, shorter routes are scanned in full.
+  inline bool EnumerateNeighborVisits(const NeighborLists &neighbors, int route_length,
+                                      std::initializer_list<Node> customers) {
+    // Every list holds at least the customer itself
+    if (!neighbors.IsGranular() || static_cast<size_t>(route_length) <= kNeighborScanCost * customers.size()) {
+      return false;
+    }
+    size_t num_neighbors = 0;
+    for (Node customer : customers) {
+      num_neighbors += neighbors.Neighbors(customer).size();
+    }
+    return kNeighborScanCost * num_neighbors < static_cast<size_t>(route_length);
+  }
+
+  // Nodes of a route paired with a node of another route: every node of the route in order, or
+  // only the nodes collected from the neighbor lists, each once
+  class CandidateNodes {
+  public:
+    // Visit every node of the route starting at head
+    void Scan(Node head) {
+      collected_ = false;
+      head_ = head;
+    }
+
+    // Visit only the nodes added next, in a solution whose node indices are at most max_node_index
+    void Collect(Node max_node_index) {
+      collected_ = true;
+      nodes_.clear();
+      added_.Reset(max_node_index + 1);
+    }
+
+    // Add a node to visit, skipping zero and the nodes already added
+    void Add(Node node_index) {
+      if (node_index && added_.Insert(node_index)) {
+        nodes_.push_back(node_index);
+      }
+    }
+
+    // First node to visit, zero if there is none
+    Node First() {
+      next_ = 0;
+      return collected_ ? NextCollected() : head_;
+    }
+
+    // Node visited after node_index, zero after the last one
+    Node Next(const SpecificSolution &solution, Node node_index) {
+      return collected_ ? NextCollected() : solution.Successor(node_index);
+    }
+
+  private:
+    Node NextCollected() { return next_ < nodes_.size() ? nodes_[next_++] : 0; }
+
+    bool collected_ = false; // Whether only the added nodes are visited
+    Node head_ = 0; // First node of the scanned route
+    size_t next_ = 0; // Position of the next added node to visit
+    std::vector<Node> nodes_; // Added nodes, in the order they were added
+    EpochTable<bool> added_; // Nodes already added since the last collection
+  };
+
+  // The two routes changed by an inter-route move
+  using ModifiedRoutes = std::array<Node, 2>;
+
+  // Best move found by an inter-operator, kept apart from the solution until it is applied
+  struct InterMove {
+    Delta<int> delta; // Change of the objective, zero if there is no move
+
+    /*Applies the move and returns the modified routes. Only set for improving moves. The move itself
+      stays in the cache of the operator, so the function is small enough not to allocate. */
+    std::function<ModifiedRoutes(SpecificSolution &, RouteContext &)> apply;
+
+    // Whether applying the move improves the solution
+    bool Improves() const { return delta.value < 0; }
+  };
+
   // Base class for inter-operators
   class InterOperator {
   public:
 
     virtual ~InterOperator() = default;
 
+    /*The best move of the operator, only improving moves can be applied. Evaluation changes nothing but
+      the caches of the operator, so operators prepared by Prepare can be evaluated concurrently.
+      Only moves creating an edge between neighbors are considered. */
+    virtual InterMove Evaluate(const Problem &problem, const SpecificSolution &solution,
+                               const RouteContext &context, CacheMap &cache_map,
+                               const SearchContext &search) const = 0;
+
+    // Name of the operator in statistics
+    virtual std::string Name() const = 0;
+
+    // Creates the caches used by Evaluate, and fills those shared with other operators
+    virtual void Prepare(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                         CacheMap &cache_map, const SearchContext &search) const = 0;
+
     /*A vector of route indices representing the modified routes. Empty if the operator
       fails to optimize the solution. */
-    virtual std::vector<Node> operator()(const Problem &problem, SpecificSolution &solution,
-                                         RouteContext &context, 
-                                         CacheMap &cache_map) const = 0;
+    std::vector<Node> operator()(const Problem &problem, SpecificSolution &solution, RouteContext &context,
+                                 CacheMap &cache_map, const SearchContext &search) const {
+      InterMove move = Evaluate(problem, solution, context, cache_map, search);
+      if (!move.Improves()) {
+        return {};
+      }
+      ModifiedRoutes routes = move.apply(solution, context);
+      return {routes.begin(), routes.end()};
+    }
   };
 
   // Inter-operator that performs a Swap(num_x, num_y) operation.
   template <int num_x, int num_y> class Swap : public InterOperator {
   public:
-    std::vector<Node> operator()(const Problem &problem, SpecificSolution &solution, RouteContext &context,
-                                 CacheMap &cache_map) const override;
+    std::string Name() const override {
+      return "Swap(" + std::to_string(num_x) + ", " + std::to_string(num_y) + ")";
+    }
+    InterMove Evaluate(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                       CacheMap &cache_map, const SearchContext &search) const override;
+    void Prepare(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                 CacheMap &cache_map, const SearchContext &search) const override;
   };
 
   // Inter-operator that performs a Relocate operation.
   class Relocate : public InterOperator {
   public:
-    std::vector<Node> operator()(const Problem &problem, SpecificSolution &solution, RouteContext &context,
-                                 CacheMap &cache_map) const;
+    std::string Name() const override { return "Relocate"; }
+    InterMove Evaluate(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                       CacheMap &cache_map, const SearchContext &search) const;
+    void Prepare(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                 CacheMap &cache_map, const SearchContext &search) const;
   };
 
   // Inter-operator that performs a Swap* operation.
   class SwapStar : public InterOperator {
   public:
-    std::vector<Node> operator()(const Problem &problem, SpecificSolution &solution, RouteContext &context,
-                                 CacheMap &cache_map) const;
+    std::string Name() const override { return "Swap*"; }
+    InterMove Evaluate(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                       CacheMap &cache_map, const SearchContext &search) const;
+    void Prepare(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                 CacheMap &cache_map, const SearchContext &search) const;
   };
 
   /**
@@ -47,29 +192,41 @@
    */
   class Cross : public InterOperator {
   public:
-    std::vector<Node> operator()(const Problem &problem, SpecificSolution &solution, RouteContext &context,
-                                 CacheMap &cache_map) const;
+    std::string Name() const override { return "Cross"; }
+    InterMove Evaluate(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                       CacheMap &cache_map, const SearchContext &search) const;
+    void Prepare(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                 CacheMap &cache_map, const SearchContext &search) const;
   };
 
   // Inter-operator that performs a SD-Swap* operation.
   class SdSwapStar : public InterOperator {
   public:
-    std::vector<Node> operator()(const Problem &problem, SpecificSolution &solution, RouteContext &context,
-                                 CacheMap &cache_map) const;
+    std::string Name() const override { return "SD-Swap*"; }
+    InterMove Evaluate(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                       CacheMap &cache_map, const SearchContext &search) const;
+    void Prepare(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                 CacheMap &cache_map, const SearchContext &search) const;
   };
 
   // Inter-operator that performs a SD-Swap(1, 1) operation.
   class SdSwapOneOne : public InterOperator {
   public:
-    std::vector<Node> operator()(const Problem &problem, SpecificSolution &solution, RouteContext &context,
-                                 CacheMap &cache_map) const;
+    std::string Name() const override { return "SD-Swap(1, 1)"; }
+    InterMove Evaluate(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                       CacheMap &cache_map, const SearchContext &search) const;
+    void Prepare(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                 CacheMap &cache_map, const SearchContext &search) const;
   };
 
   // Inter-operator that performs a SD-Swap(2, 1) operation.
   class SdSwapTwoOne : public InterOperator {
   public:
-    std::vector<Node> operator()(const Problem &problem, SpecificSolution &solution, RouteContext &context,
-                                CacheMap &cache_map) const;
+    std::string Name() const override { return "SD-Swap(2, 1)"; }
+    InterMove Evaluate(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                       CacheMap &cache_map, const SearchContext &search) const;
+    void Prepare(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                 CacheMap &cache_map, const SearchContext &search) const;
   };
 
 #endif
\ No newline at end of file
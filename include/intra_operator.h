@@ -4,12 +4,14 @@
 #include "problem.h"
 #include "solution.h"
 #include "route_context.h"//
+#include <string>
 #include <vector>
 
 // Base class for intra-operators
 class IntraOperator {
 public:
   virtual ~IntraOperator() = default;
+  virtual std::string Name() const = 0; // Name of the operator in statistics
   virtual bool operator()(const Problem &problem, Node route_index, SpecificSolution &solution,
                           RouteContext &context) const = 0;
 };
@@ -17,6 +19,7 @@ public:
 // This operator swaps the positions of two nodes within a single route.
 class Exchange : public IntraOperator {
 public:
+  std::string Name() const override { return "Exchange"; }
   bool operator()(const Problem &problem, Node route_index, SpecificSolution &solution,
                   RouteContext &context) const;
 };
@@ -24,6 +27,7 @@ public:
 // This operator moves consecutive `num` nodes from one position in a route to another.
 template <int num> class OrOpt : public IntraOperator {
 public:
+  std::string Name() const override { return "Or-opt(" + std::to_string(num) + ")"; }
   bool operator()(const Problem &problem, Node route_index, SpecificSolution &solution,
                   RouteContext &context) const override;
 };
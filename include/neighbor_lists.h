@@ -0,0 +1,51 @@
+#ifndef NEIGHBOR_LISTS_H
+#define NEIGHBOR_LISTS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "problem.h"
+
+// The k nearest customers of every customer, used to restrict the inter-route operators to
+// granular neighborhoods. Two customers are neighbors if either is among the k nearest of the
+// other. The depot is a neighbor of every customer, so moves at the ends of routes stay possible.
+class NeighborLists
+{
+public:
+    // Without neighbor lists every edge is accepted
+    NeighborLists() = default;
+
+    // Build the lists of the num_neighbors nearest customers. Zero disables the restriction.
+    NeighborLists(const Problem &problem, int num_neighbors);
+
+    // Whether the operators are restricted to granular neighborhoods
+    bool IsGranular() const { return granular_; }
+
+    // Whether the edge between customers a and b belongs to the granular neighborhood
+    bool IsNeighbor(Node a, Node b) const
+    {
+        if (!granular_ || a == 0 || b == 0) return true;
+        size_t bit = static_cast<size_t>(a) * size_ + b;
+        return (bits_[bit >> 6] >> (bit & 63)) & 1;
+    }
+
+    // Whether inserting the segment from customer left to customer right between the customers
+    // predecessor and successor creates an edge of the granular neighborhood, in either direction
+    bool IsNeighborInsertion(Node left, Node right, Node predecessor, Node successor) const
+    {
+        return IsNeighbor(left, predecessor) || IsNeighbor(left, successor)
+               || IsNeighbor(right, predecessor) || IsNeighbor(right, successor);
+    }
+
+    // Customers forming a granular edge with a customer, closest first: its nearest customers,
+    // those it is among the nearest of, and the customer itself. Empty for the depot.
+    const std::vector<Node> &Neighbors(Node customer) const { return lists_[customer]; }
+
+private:
+    bool granular_ = false; // Whether the neighborhoods are restricted
+    size_t size_ = 0; // Number of customers, including the depot
+    std::vector<std::vector<Node>> lists_; // Neighbors of every customer, in both directions
+    std::vector<uint64_t> bits_; // Symmetric neighbor relation as a bit matrix
+};
+
+#endif
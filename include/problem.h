@@ -1,7 +1,11 @@
 #ifndef PROBLEM_H
 #define PROBLEM_H
 
+#include <utility>
 #include <vector>
+
+#include "distance_matrix.h"
+
 using namespace std;
 
 using Node = short;
@@ -11,7 +15,8 @@ struct Problem{
   Node num_customers;                   // The number of customers, including the depot.
   int capacity;                        // The capacity of the vehicles.
   vector<int> demands;                 // The demands of each customer, including the depot
-  vector<vector<int>> distance_matrix; // The distance matrix between customers, including the depot.
+  DistanceMatrix distance_matrix;      // The distance matrix between customers, including the depot.
+  vector<pair<int, int>> coordinates;  // The locations of the customers, including the depot. May be empty.
 };
 
 #endif
\ No newline at end of file
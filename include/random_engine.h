@@ -0,0 +1,71 @@
+#ifndef RANDOM_ENGINE_H
+#define RANDOM_ENGINE_H
+
+#include <cstdint>
+#include <limits>
+
+// xoshiro256** pseudo random number generator. It satisfies UniformRandomBitGenerator,
+// so it can be passed to std::shuffle and the <random> distributions.
+class RandomEngine
+{
+public:
+    using result_type = uint64_t;
+
+    constexpr explicit RandomEngine(uint64_t seed = 0) : state_{} { Seed(seed); }
+
+    // Seed the engine. Different streams of the same seed give independent sequences.
+    constexpr void Seed(uint64_t seed, uint64_t stream = 0)
+    {
+        uint64_t x = seed + stream * 0xd1b54a32d192ed03ULL;
+        for (auto &word : state_)
+        {
+            // SplitMix64, as recommended by the authors of xoshiro
+            x += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = x;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        uint64_t result = Rotl(state_[1] * 5, 7) * 9;
+        uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = Rotl(state_[3], 45);
+        return result;
+    }
+
+    // Uniform integer in [0, n)
+    uint32_t Below(uint32_t n)
+    {
+        return static_cast<uint32_t>(((*this)() >> 32) * n >> 32);
+    }
+
+    // Uniform real number in [0, 1)
+    double Uniform()
+    {
+        return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+    }
+
+private:
+    static constexpr uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t state_[4];
+};
+
+// Engine of the calling thread. Every search thread seeds its own engine from Config::random_seed,
+// so runs are reproducible and the engines are never shared between threads.
+inline thread_local RandomEngine thread_random_engine;
+
+inline RandomEngine &ThreadRandom() { return thread_random_engine; }
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef RANKINGS_H
+#define RANKINGS_H
+
+#include <vector>
+
+#include "problem.h"
+
+// Orders of the customers used by the perturbation, computed once per problem. Every customer and
+// the depot has its nearest customers in distance order, and every customer has its rank by
+// distance from the depot and by demand.
+class Rankings
+{
+public:
+    Rankings() = default;
+
+    // Rank the depth nearest customers of every customer. Zero ranks all of them.
+    Rankings(const Problem &problem, int depth);
+
+    // Nearest customers of a customer or the depot, closest first and ties by index. A customer
+    // is among its own nearest customers.
+    const std::vector<Node> &Nearest(Node customer) const { return nearest_[customer]; }
+
+    // Rank of a customer by distance from the depot, closest first. Equal distances share a rank.
+    int DepotDistanceRank(Node customer) const { return depot_distance_ranks_[customer]; }
+
+    // Rank of a customer by demand, smallest first. Equal demands share a rank.
+    int DemandRank(Node customer) const { return demand_ranks_[customer]; }
+
+private:
+    std::vector<std::vector<Node>> nearest_; // Nearest customers of every customer and the depot
+    std::vector<int> depot_distance_ranks_; // Rank of every customer by distance from the depot
+    std::vector<int> demand_ranks_; // Rank of every customer by demand
+};
+
+#endif
@@ -4,6 +4,7 @@
 #include "problem.h"
 #include "solution.h"
 
+#include <atomic>
 #include <vector>
 
 // Contains information regarding the routes that are currently decided.
@@ -11,30 +12,62 @@ class RouteContext
 {
 public:
 
+    explicit RouteContext(const Problem &problem);
+
     Node Head(Node route_index) const; // Get head of a route
     Node Tail(Node route_index) const; // Get tail of a route
     int Load(Node route_index) const; // Get load of a route
     int PreLoad(Node node_index) const; // Get prefix load upto a node
+    Node RouteIndex(Node node_index) const; // Get the route of a node, as of the last update of its route
+    int Position(Node node_index) const; // Get the position of a node in its route, zero for the head
+    int Length(Node route_index) const; // Get the number of nodes of a route
+    int Cost(Node route_index) const; // Get travel cost of a route
+    int Objective() const; // Get total travel cost of all routes
+    bool Overlap(Node route_a, Node route_b) const; // Whether the polar sectors and bounding boxes of two routes overlap
     void SetHead(Node route_index, Node head); // Set a node as the head of a route
     void AddLoad(Node route_index, int load);  // Add load to a route
     Node NumRoutes() const; // Return number of routes
     void SetNumRoutes(Node num_routes); // Set the number of routes
     void AddRoute(Node head, Node tail, int load); // Add a new route
     void CalcRouteContext(const SpecificSolution &solution); // Calculate the context of a route
+    void ResizeNodes(const SpecificSolution &solution); // Size the node arrays to the nodes of a solution, after nodes are created
     void UpdateRouteContext(const SpecificSolution &solution, Node route_index, Node predecessor); // Update the context of a route
     void MoveRouteContext(Node dest_route_index, Node src_route_index); // Move information of one route from one index to other
 
 private:
 
+    // Arc of polar angles around the depot, in 1/65536 of a turn, from start counterclockwise to end
+    struct Sector
+    {
+        int start = 0;
+        int end = 0;
+    };
+
     struct RouteData 
     {
         Node head; // Head of the route
         Node tail; // Tail of the route
         int load;  // Total load delivered along a route
+        int cost;  // Travel cost of the route, depot to depot
+        Sector sector{}; // Polar sector covering the customers of the route
+        int min_x = 0, max_x = 0, min_y = 0, max_y = 0; // Bounding box of the customers of the route
+        Node id = 0; // Id of the route, kept when the route moves to another index
     };
 
+    Node NewRouteId(Node route_index); // Give a route an unused id
+
+    void ExtendRouteGeometry(Node route_index, Node customer, bool head); // Extend the sector and bounding box of a route by a customer
+
+    const Problem *problem_; // Problem the routes belong to
+    std::vector<int> polar_angles_; // Polar angle of each customer around the depot, empty without coordinates
     std::vector<RouteData> routes_; // Routes decided by the algorithm
     std::vector<int> pre_loads_; // Cumulative load for each node
+    std::vector<int> pre_costs_; // Cumulative travel cost from the depot to each node
+    std::vector<Node> route_ids_; // Route id of each node
+    std::vector<Node> route_indices_; // Route index of each route id
+    std::vector<Node> free_route_ids_; // Ids of the dropped routes
+    std::vector<int> positions_; // Position of each node in its route
+    std::atomic<int> objective_{0}; // Sum of the costs of all routes, updated by routes searched in parallel
 };
 
 #endif
\ No newline at end of file
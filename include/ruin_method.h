@@ -6,15 +6,16 @@
 #include "problem.h"
 #include "solution.h"
 #include "route_context.h"
+#include "rankings.h"
 
 // Base class for Ruin methods
 class RuinMethod
 {
 public:
 
-    // Ruin strategy to perturb a random number of customers.
-    virtual vector<Node> Ruin(const Problem &problem, SpecificSolution &solution,
-                                   RouteContext &context) = 0;
+    // Ruin strategy to perturb a random number of customers, which replace the given ones.
+    virtual void Ruin(const Problem &problem, const Rankings &rankings, SpecificSolution &solution,
+                      RouteContext &context, vector<Node> &customers) = 0;
 };
 
 // Random ruin class
@@ -24,8 +25,8 @@ public:
 
     explicit RandomRuin(vector<int> num_perturb_customers);
 
-    vector<Node> Ruin(const Problem &problem, SpecificSolution &solution, 
-                        RouteContext &context) override;
+    void Ruin(const Problem &problem, const Rankings &rankings, SpecificSolution &solution,
+              RouteContext &context, vector<Node> &customers) override;
 
 private:
 
@@ -40,13 +41,11 @@ public:
     SisrsRuin(int average_customers, int max_length, double split_rate,
               double preserved_probability);
 
-    vector<Node> Ruin(const Problem &problem, SpecificSolution &solution, 
-                        RouteContext &context) override;
+    void Ruin(const Problem &problem, const Rankings &rankings, SpecificSolution &solution,
+              RouteContext &context, vector<Node> &customers) override;
 
 private:
 
-    static Node GetRouteHead(SpecificSolution &solution, Node node_index, int &position); // Get head of a route
-    static void GetRoute(const SpecificSolution &solution, Node head, vector<Node> &route); // Get the complete route, starting from the head
     int average_customers_; // Average number of removed customers
     int max_length_; // Maximum cardinality of removed strings
     double split_rate_; // Probability of executing the split string
@@ -0,0 +1,17 @@
+#ifndef SETUP_H
+#define SETUP_H
+
+#include <string>
+
+#include "config.h"
+#include "problem.h"
+
+// Reading the instances and the solver configuration, shared by the test runner and the benchmarks
+
+// Read problem data from a file
+Problem ReadProblemFromFile(const std::string &problem_path);
+
+// Build the solver configuration used for every instance
+SpecificConfig MakeConfig(int num_threads);
+
+#endif
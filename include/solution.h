@@ -3,6 +3,7 @@
 
 #include "problem.h"
 #include <ostream>
+#include <stdexcept>
 #include <vector>
 
 using namespace std;
@@ -16,18 +17,20 @@ public:
 // Derived class
 class SpecificSolution : public Solution {
 public:
+    class RouteChanges;
+
     SpecificSolution() { 
         node_data_.push_back({}); 
     }
 
     // Get predecessor of a node
     Node Predecessor(Node node_index) const { 
-        return node_data_[node_index].predecessor; 
+        return Links(node_index).predecessor; 
     }
 
     // Get successor of a node
     Node Successor(Node node_index) const { 
-        return node_data_[node_index].successor; 
+        return Links(node_index).successor; 
     }
 
     // Get the customer number
@@ -40,23 +43,45 @@ public:
         return node_data_[node_index].load; 
     }
 
+    // Get the first node visiting a customer, zero if there is none
+    Node FirstVisit(Node customer) const {
+        return static_cast<size_t>(customer) < first_visits_.size() ? first_visits_[customer] : 0;
+    }
+
+    // Get the next node visiting the customer of a node, zero after the last one. Nodes removed while
+    // the changes of a route are buffered stay visits until the changes are merged.
+    Node NextVisit(Node node_index) const {
+        return node_data_[node_index].next_visit;
+    }
+
     // Set the predecessor of a node
     void SetPredecessor(Node node_index, Node predecessor) {
-        node_data_[node_index].predecessor = predecessor;
+        NodeData &node = Links(node_index);
+        Record(ChangeType::kPredecessor, node_index, node.predecessor);
+        node.predecessor = predecessor;
     }
 
     // Set the successor of a node
     void SetSuccessor(Node node_index, Node successor) {
-        node_data_[node_index].successor = successor;
+        NodeData &node = Links(node_index);
+        Record(ChangeType::kSuccessor, node_index, node.successor);
+        node.successor = successor;
     }
 
-    // Set the customer for a node
+    // Set the customer for a node, moving it to the visits of the customer
     void SetCustomer(Node node_index, Node customer) { 
+        if (route_changes_) {
+            throw std::logic_error("Customers cannot be changed while the changes of a route are buffered");
+        }
+        Record(ChangeType::kCustomer, node_index, node_data_[node_index].customer);
+        RemoveVisit(node_index);
         node_data_[node_index].customer = customer; 
+        AddVisit(node_index);
     }
 
     // Set the load for a node
     void SetLoad(Node node_index, int load) { 
+        Record(ChangeType::kLoad, node_index, node_data_[node_index].load);
         node_data_[node_index].load = load; 
     }
 
@@ -66,14 +91,12 @@ public:
         Node successor = Successor(node_index);
         Link(predecessor, successor);
 
-        Node index_in_used_nodes = node_data_[node_index].index_in_used_nodes;
-        Node last_node = used_nodes_.back();
-        
-        node_data_[last_node].index_in_used_nodes = index_in_used_nodes;
-        used_nodes_[index_in_used_nodes] = last_node;
-        
-        used_nodes_.pop_back();
-        unused_nodes_.push_back(node_index);
+        // The node pool is shared by all routes, so changes to a single route release it later
+        if (route_changes_) {
+            route_changes_->removed_nodes_.push_back(node_index);
+            return;
+        }
+        Release(node_index);
     }
 
     // Add a node
@@ -86,19 +109,27 @@ public:
 
     // Create a new node
     Node NewNode(Node customer, int load) {
+        if (route_changes_) {
+            throw std::logic_error("Nodes cannot be created while the changes of a route are buffered");
+        }
         Node node_index;
 
-        if (unused_nodes_.empty()) {
+        bool reused = !unused_nodes_.empty();
+        if (!reused) {
             node_index = node_data_.size();
             node_data_.push_back({});
         } else {
             node_index = unused_nodes_.back();
             unused_nodes_.pop_back();
         }
+        Record(ChangeType::kNewNode, node_index, reused);
 
         node_data_[node_index].index_in_used_nodes = used_nodes_.size();
         used_nodes_.push_back(node_index);
-        
+
+        // The node joins the visits of its former customer, the depot for a new node, so that
+        // SetCustomer and its rollback move it like any other visit
+        AddVisit(node_index);
         SetCustomer(node_index, customer);
         SetLoad(node_index, load);
 
@@ -131,11 +162,11 @@ public:
             Node successor = Successor(node_index);
             
             // Distance between predecessor and current node
-            objective += problem.distance_matrix[Customer(node_index)][Customer(predecessor)];
+            objective += problem.distance_matrix(Customer(node_index), Customer(predecessor));
             
             // If the current node is end of the route
             if (successor == 0) {
-                objective += problem.distance_matrix[Customer(node_index)][0];
+                objective += problem.distance_matrix(Customer(node_index), 0);
             }
         }
 
@@ -159,6 +190,79 @@ public:
         Link(left, successor);
     }
 
+    // Start recording changes, so that they can be undone by Rollback
+    void Checkpoint() {
+        journal_.clear();
+        journaling_ = true;
+    }
+
+    // Keep the changes made since the checkpoint and stop recording
+    void Commit() {
+        journal_.clear();
+        journaling_ = false;
+    }
+
+    // Undo the changes made since the checkpoint, in reverse order, and stop recording.
+    // Takes time proportional to the number of changes, and restores the node indices
+    // and the order of NodeIndices exactly. The visits of a customer may change order.
+    void Rollback() {
+        for (auto it = journal_.rbegin(); it != journal_.rend(); ++it) {
+            NodeData &node = node_data_[it->node_index];
+            switch (it->type) {
+            case ChangeType::kPredecessor:
+                node.predecessor = it->value;
+                break;
+            case ChangeType::kSuccessor:
+                node.successor = it->value;
+                break;
+            case ChangeType::kCustomer:
+                RemoveVisit(it->node_index);
+                node.customer = it->value;
+                AddVisit(it->node_index);
+                break;
+            case ChangeType::kLoad:
+                node.load = it->value;
+                break;
+            case ChangeType::kNewNode:
+                RemoveVisit(it->node_index);
+                used_nodes_.pop_back();
+                if (it->value) {
+                    unused_nodes_.push_back(it->node_index);
+                } else {
+                    node_data_.pop_back();
+                }
+                break;
+            case ChangeType::kRemove:
+                // The last used node was moved into the slot of the removed one
+                unused_nodes_.pop_back();
+                node_data_[it->moved_node].index_in_used_nodes = used_nodes_.size();
+                used_nodes_.push_back(it->moved_node);
+                node.index_in_used_nodes = it->value;
+                used_nodes_[it->value] = it->node_index;
+                AddVisit(it->node_index);
+                break;
+            }
+        }
+        Commit();
+    }
+
+    // Buffer the changes of the calling thread in changes until EndRouteChanges, so that threads can
+    // change disjoint routes at the same time. The thread gets its own links of the depot sentinel
+    // (node 0), its changes are journaled into the buffer and removed nodes stay in the node pool.
+    // Nodes cannot be created meanwhile.
+    void BeginRouteChanges(RouteChanges &changes) {
+        changes.sentinel_ = node_data_[0];
+        route_changes_ = &changes;
+    }
+
+    // Stop buffering the changes of the calling thread
+    void EndRouteChanges() {
+        route_changes_ = nullptr;
+    }
+
+    // Journal the buffered changes and release the removed nodes, as if the changes were made now
+    void MergeRouteChanges(RouteChanges &changes);
+
     // Output the solution
     friend ostream& operator<<(ostream &os, const SpecificSolution &solution) {
         Node num_routes = 0;
@@ -184,13 +288,154 @@ private:
         Node successor; // Successor of the node
         Node predecessor; // Predecessor of the node
         Node customer; // Customer corresponding to the node
+        Node previous_visit; // Previous used node of the same customer, zero for the first
         int load; // Load for the node
         Node index_in_used_nodes; // Index in the vector used_nodes_
+        Node next_visit; // Next used node of the same customer, zero for the last
+    };
+
+    // Kinds of changes recorded in the journal
+    enum class ChangeType : unsigned char {
+        kPredecessor, kSuccessor, kCustomer, kLoad, kNewNode, kRemove
     };
 
+    // A change made after Checkpoint, with what is needed to undo it
+    struct Change {
+        ChangeType type;
+        Node node_index; // Node that was changed
+        Node moved_node; // Node moved into the slot of a removed node in used_nodes_
+        int value; // Previous value of the field, whether NewNode reused an unused node, or the
+                   // position of a removed node in used_nodes_
+    };
+
+    // Record a change if a checkpoint is active
+    void Record(ChangeType type, Node node_index, int value, Node moved_node = 0) {
+        if (journaling_) {
+            (route_changes_ ? route_changes_->journal_ : journal_).push_back({type, node_index, moved_node, value});
+        }
+    }
+
+    // Links of a node. The depot sentinel of a thread buffering route changes is its own.
+    NodeData &Links(Node node_index) {
+        return node_index == 0 && route_changes_ ? route_changes_->sentinel_ : node_data_[node_index];
+    }
+    const NodeData &Links(Node node_index) const {
+        return node_index == 0 && route_changes_ ? route_changes_->sentinel_ : node_data_[node_index];
+    }
+
+    // Put a used node first among the visits of its customer
+    void AddVisit(Node node_index) {
+        NodeData &node = node_data_[node_index];
+        if (static_cast<size_t>(node.customer) >= first_visits_.size()) {
+            first_visits_.resize(node.customer + 1);
+        }
+        Node &first = first_visits_[node.customer];
+        node.previous_visit = 0;
+        node.next_visit = first;
+        if (first) {
+            node_data_[first].previous_visit = node_index;
+        }
+        first = node_index;
+    }
+
+    // Take a node out of the visits of its customer
+    void RemoveVisit(Node node_index) {
+        const NodeData &node = node_data_[node_index];
+        if (node.previous_visit) {
+            node_data_[node.previous_visit].next_visit = node.next_visit;
+        } else {
+            first_visits_[node.customer] = node.next_visit;
+        }
+        if (node.next_visit) {
+            node_data_[node.next_visit].previous_visit = node.previous_visit;
+        }
+    }
+
+    // Move a removed node from the used to the unused nodes
+    void Release(Node node_index) {
+        Node index_in_used_nodes = node_data_[node_index].index_in_used_nodes;
+        Node last_node = used_nodes_.back();
+        
+        Record(ChangeType::kRemove, node_index, index_in_used_nodes, last_node);
+        RemoveVisit(node_index);
+        node_data_[last_node].index_in_used_nodes = index_in_used_nodes;
+        used_nodes_[index_in_used_nodes] = last_node;
+        
+        used_nodes_.pop_back();
+        unused_nodes_.push_back(node_index);
+    }
+
     vector<NodeData> node_data_; // Data of all nodes
     vector<Node> used_nodes_; // List of nodes used
     vector<Node> unused_nodes_; // List of nodes that are not used
+    vector<Node> first_visits_; // First used node of each customer, heading its list of visits
+    vector<Change> journal_; // Changes since the last checkpoint
+    bool journaling_ = false; // Whether changes are recorded
+    static inline thread_local RouteChanges *route_changes_ = nullptr; // Buffer of the calling thread, if any
+
+public:
+    // Changes made to a single route by one thread, see BeginRouteChanges
+    class RouteChanges {
+    private:
+        friend class SpecificSolution;
+
+        NodeData sentinel_{}; // Links of the depot sentinel seen by the thread
+        vector<Change> journal_; // Changes to journal
+        vector<Node> removed_nodes_; // Nodes to release
+    };
+};
+
+inline void SpecificSolution::MergeRouteChanges(RouteChanges &changes) {
+    if (journaling_) {
+        journal_.insert(journal_.end(), changes.journal_.begin(), changes.journal_.end());
+    }
+    for (Node node_index : changes.removed_nodes_) {
+        Release(node_index);
+    }
+    changes.journal_.clear();
+    changes.removed_nodes_.clear();
+}
+
+// Compact copy of the routes of a solution, as sequences of customers and loads
+class SolutionSnapshot {
+public:
+    // Copy the routes of a solution, in the order of their heads in NodeIndices
+    void Capture(const SpecificSolution &solution) {
+        visits_.clear();
+        route_ends_.clear();
+        for (Node node_index : solution.NodeIndices()) {
+            if (solution.Predecessor(node_index)) {
+                continue;
+            }
+            for (; node_index; node_index = solution.Successor(node_index)) {
+                visits_.push_back({solution.Customer(node_index), solution.Load(node_index)});
+            }
+            route_ends_.push_back(visits_.size());
+        }
+    }
+
+    // Build a solution with the captured routes
+    SpecificSolution Restore() const {
+        SpecificSolution solution;
+        size_t begin = 0;
+        for (size_t end : route_ends_) {
+            Node predecessor = 0;
+            for (size_t i = begin; i < end; ++i) {
+                predecessor = solution.Insert(visits_[i].customer, visits_[i].load, predecessor, 0);
+            }
+            begin = end;
+        }
+        return solution;
+    }
+
+private:
+    struct Visit {
+        Node customer; // Customer served
+        int load; // Load delivered
+    };
+
+    vector<Visit> visits_; // Visits of all routes, route after route
+    vector<size_t> route_ends_; // End of each route in visits_
 };
 
 
@@ -2,6 +2,7 @@
 #define SORTER_H
 
 #include "problem.h"
+#include "rankings.h"
 
 #include <memory>
 #include <vector>
@@ -12,7 +13,7 @@ class SortOperator
 public:
     virtual ~SortOperator() = default;
 
-    virtual void operator()(const Problem &problem, std::vector<Node> &customers) const = 0;
+    virtual void operator()(const Problem &problem, const Rankings &rankings, std::vector<Node> &customers) const = 0;
 };
 
 class Sorter
@@ -23,7 +24,7 @@ public:
     void AddSortFunction(std::unique_ptr<SortOperator> &&sort_function, double weight);
 
     // Sort customers using a randomly selected sort function based on weights.
-    void Sort(const Problem &problem, std::vector<Node> &customers) const;
+    void Sort(const Problem &problem, const Rankings &rankings, std::vector<Node> &customers) const;
 
 private:
     double sum_weights_ = 0;
@@ -34,28 +35,28 @@ private:
 class SortByRandom : public SortOperator
 {
 public:
-    void operator()(const Problem &problem, std::vector<Node> &customers) const override;
+    void operator()(const Problem &problem, const Rankings &rankings, std::vector<Node> &customers) const override;
 };
 
 // Sort customers by demand in descending order.
 class SortByDemand : public SortOperator
 {
 public:
-    void operator()(const Problem &problem, std::vector<Node> &customers) const override;
+    void operator()(const Problem &problem, const Rankings &rankings, std::vector<Node> &customers) const override;
 };
 
 // Sort customers by distance from the depot (farthest first).
 class SortByFar : public SortOperator
 {
 public:
-    void operator()(const Problem &problem, std::vector<Node> &customers) const override;
+    void operator()(const Problem &problem, const Rankings &rankings, std::vector<Node> &customers) const override;
 };
 
 // Sort customers by distance from the depot (closest first).
 class SortByClose : public SortOperator
 {
 public:
-    void operator()(const Problem &problem, std::vector<Node> &customers) const override;
+    void operator()(const Problem &problem, const Rankings &rankings, std::vector<Node> &customers) const override;
 };
 
 #endif
@@ -0,0 +1,74 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+// Runtime of an operator, summed over all calls
+struct OperatorStatistics
+{
+    std::string name;
+    uint64_t num_calls = 0;
+    uint64_t num_improvements = 0; // Calls that changed the solution
+    int64_t total_improvement = 0; // Decrease of the objective by the improving calls
+    uint64_t nanoseconds = 0;
+};
+
+// Lookups of a cache that either reused an entry or had to compute it
+struct CacheStatistics
+{
+    std::string name;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+// Statistics of a search, summed over all search threads
+struct SearchStatistics
+{
+    std::vector<OperatorStatistics> inter_operators; // In the order of the configuration
+    std::vector<OperatorStatistics> intra_operators; // In the order of the configuration
+    std::vector<CacheStatistics> caches; // Caches that were looked up, in the order they were first created
+};
+
+// Readable name of a type, demangled where the compiler supports it
+std::string TypeName(const std::type_info &type);
+
+// Collects the statistics of a search. Operators are recorded from any thread.
+class StatisticsRecorder
+{
+public:
+    StatisticsRecorder(size_t num_inter_operators, size_t num_intra_operators);
+
+    // Record a call of an operator that decreased the objective by improvement
+    void RecordInter(size_t index, uint64_t nanoseconds, int improvement);
+    void RecordIntra(size_t index, uint64_t nanoseconds, int improvement);
+
+    // Add the lookups of caches, merged with earlier caches of the same name
+    void AddCaches(const std::vector<CacheStatistics> &caches);
+
+    // Statistics recorded so far. The operator names are left to the caller.
+    SearchStatistics Statistics() const;
+
+private:
+    struct Counters
+    {
+        std::atomic<uint64_t> num_calls{0};
+        std::atomic<uint64_t> num_improvements{0};
+        std::atomic<int64_t> total_improvement{0};
+        std::atomic<uint64_t> nanoseconds{0};
+    };
+
+    static void Record(Counters &counters, uint64_t nanoseconds, int improvement);
+    static OperatorStatistics Snapshot(const Counters &counters);
+
+    std::vector<Counters> inter_operators_; // Counters of the inter-operators
+    std::vector<Counters> intra_operators_; // Counters of the intra-operators
+    mutable std::mutex mutex_; // Guards caches_
+    std::vector<CacheStatistics> caches_; // Merged lookups of the caches
+};
+
+#endif
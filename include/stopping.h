@@ -0,0 +1,82 @@
+#ifndef STOPPING_H
+#define STOPPING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Cooperative cancellation of a search. Any thread may cancel it, and the search checks it between
+// operator calls, so it stops soon after without leaving a solution half changed.
+class CancellationToken
+{
+public:
+    void Cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    bool IsCancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> cancelled_{false};
+};
+
+// Limits of a search besides the time limit. A limit of zero is not set. The counts are summed over
+// all search threads, so with a single search thread and a fixed seed the search stops at the same
+// point of the same trajectory on every machine.
+struct StoppingCriteria
+{
+    uint64_t max_iterations = 0; // Iterations of the iterated local search
+    uint64_t max_restarts = 0; // Restarts that ended by stagnation
+    uint64_t max_evaluations = 0; // Calls of the inter- and intra-operators
+    int target_objective = 0; // Stop once a solution at least this good is found
+    uint64_t max_iterations_without_improvement = 0; // Iterations since the best solution improved
+    bool require_all = false; // Stop when all set limits are reached instead of any of them
+};
+
+// Progress of a search against its stopping criteria, shared by all search threads. The limits are
+// checked between iterations by ShouldStop, which also cancels the search once they are reached. A
+// time limit that stops the search on its own is also checked by IsCancelled, so the search stops
+// within an iteration once the time is up.
+class StoppingCondition
+{
+public:
+    // A time limit of zero or below is not set. The search also stops when the token is cancelled, if
+    // there is one. Throws invalid_argument if neither a limit nor a token is given.
+    StoppingCondition(const StoppingCriteria &criteria, double time_limit, const CancellationToken *token);
+
+    void AddIteration() { num_iterations_.fetch_add(1, std::memory_order_relaxed); }
+    void AddRestart() { num_restarts_.fetch_add(1, std::memory_order_relaxed); }
+    void AddEvaluations(uint64_t count) { num_evaluations_.fetch_add(count, std::memory_order_relaxed); }
+
+    // Note a new best solution, called in the order the best solutions are found
+    void OnImproved(int objective);
+
+    // Whether the search should stop, cancelling it if so
+    bool ShouldStop();
+
+    // Stop the search regardless of the limits, e.g. when a search thread failed
+    void Cancel() { stopped_.Cancel(); }
+
+    // Whether the search was cancelled or ran out of time, cheap enough to check between operator
+    // calls and route pairs. Once true, it stays true.
+    bool IsCancelled() const
+    {
+        return stopped_.IsCancelled() || (token_ && token_->IsCancelled())
+               || (has_deadline_ && std::chrono::steady_clock::now() >= deadline_);
+    }
+
+    double ElapsedSeconds() const;
+
+private:
+    StoppingCriteria criteria_;
+    double time_limit_;
+    const CancellationToken *token_; // Cancellation by the caller, if any
+    CancellationToken stopped_; // Cancelled once the limits are reached
+    std::chrono::steady_clock::time_point start_time_;
+    bool has_deadline_ = false; // Whether reaching the time limit alone stops the search
+    std::chrono::steady_clock::time_point deadline_; // End of the time limit, if has_deadline_
+    std::atomic<uint64_t> num_iterations_{0};
+    std::atomic<uint64_t> num_restarts_{0};
+    std::atomic<uint64_t> num_evaluations_{0};
+    std::atomic<uint64_t> last_improvement_{0}; // Iterations done when the best solution last improved
+    std::atomic<int> best_objective_;
+};
+
+#endif
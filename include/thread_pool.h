@@ -0,0 +1,78 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "random_engine.h"
+
+// Work-stealing pool for data-parallel loops. The range of a loop is split into chunks that are
+// dealt to per-thread queues. Every thread takes chunks from the back of its own queue and steals
+// from the front of the others when it runs dry. The calling thread takes part in the work.
+class ThreadPool
+{
+public:
+    // Start num_threads - 1 workers, so the loops run on num_threads threads including the caller
+    explicit ThreadPool(int num_threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Number of threads running the loops, including the caller
+    int NumThreads() const { return static_cast<int>(queues_.size()); }
+
+    // Call function(i) for every i in [0, count) and return when all calls are done.
+    // The function must not throw, and the loops of one pool must not be nested.
+    void ParallelFor(size_t count, const std::function<void(size_t)> &function);
+
+private:
+    using Chunk = std::pair<size_t, size_t>; // Range [first, second) of loop indices
+
+    // Queue of chunks owned by one thread
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+    };
+
+    bool Pop(int thread_index, Chunk &chunk); // Take a chunk from the own queue or steal one
+    void Work(int thread_index); // Run chunks until none is left
+    void WorkerLoop(int thread_index); // Wait for loops and take part in them
+
+    std::vector<std::unique_ptr<Queue>> queues_; // Queue of each thread, the caller has index 0
+    std::vector<std::thread> workers_; // Worker threads
+    std::mutex mutex_; // Guards generation_ and stop_
+    std::condition_variable start_; // Signals a new loop or shutdown to the workers
+    std::condition_variable done_; // Signals the end of a loop to the caller
+    const std::function<void(size_t)> *function_ = nullptr; // Body of the current loop
+    size_t generation_ = 0; // Number of loops started
+    std::atomic<size_t> remaining_{0}; // Loop indices not finished yet
+    bool stop_ = false; // Whether the workers should exit
+};
+
+// Calls function(i) for every i in [0, count) on the pool. Call i draws its random numbers from
+// stream i of a seed taken from the calling thread, so the results do not depend on the number of
+// threads. The random engine of the calling thread is left as if it had drawn only the seed.
+template <class Function>
+void DeterministicParallelFor(ThreadPool &pool, size_t count, Function function)
+{
+    uint64_t seed = ThreadRandom()();
+    pool.ParallelFor(count, [&](size_t i)
+    {
+        RandomEngine saved = ThreadRandom();
+        ThreadRandom().Seed(seed, i);
+        function(i);
+        ThreadRandom() = saved;
+    });
+}
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Records timed phases of a search from any number of threads and exports them as Chrome
+// trace-event JSON, which Perfetto and chrome://tracing open. Every thread writes to its own ring
+// buffer, allocated once when the thread records its first event. A full buffer overwrites its
+// oldest events, so a long search keeps its most recent part.
+class Tracer
+{
+public:
+    // Keep up to capacity events per thread
+    explicit Tracer(size_t capacity = 1 << 20);
+
+    Tracer(const Tracer &) = delete;
+    Tracer &operator=(const Tracer &) = delete;
+
+    // Record a phase from start_time until now. The name must outlive the tracer.
+    void Complete(const char *name, std::chrono::steady_clock::time_point start_time);
+
+    // Record a point in time, such as a decision. The name must outlive the tracer.
+    void Instant(const char *name);
+
+    // Copy of a name that lives as long as the tracer, for names that are not literals
+    const char *Intern(const std::string &name);
+
+    // Write the events of all threads. The recording threads must have finished.
+    void WriteChromeTrace(std::ostream &os) const;
+
+private:
+    struct Event
+    {
+        const char *name;
+        uint64_t start; // Nanoseconds since the tracer was created
+        uint64_t duration; // Nanoseconds, zero for instants
+        char phase; // 'X' for phases and 'i' for instants, as in the trace-event format
+    };
+
+    // Ring buffer of one thread
+    struct Buffer
+    {
+        std::vector<Event> events; // Allocated to the capacity up front
+        uint64_t num_recorded = 0; // Events recorded so far, including overwritten ones
+        int thread_index; // Order in which the thread recorded its first event
+    };
+
+    void Record(const char *name, uint64_t start, uint64_t duration, char phase);
+    Buffer &ThreadBuffer(); // Buffer of the calling thread, created on its first event
+    uint64_t Nanoseconds(std::chrono::steady_clock::time_point time) const;
+
+    size_t capacity_;
+    uint64_t id_; // Distinguishes the tracer from earlier ones at the same address
+    std::chrono::steady_clock::time_point start_time_;
+    std::mutex mutex_; // Guards buffers_ and names_
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+    std::unordered_map<std::string, std::unique_ptr<std::string>> names_; // Interned names
+};
+
+// Records the phase from its construction to its destruction, if there is a tracer.
+class TraceScope
+{
+public:
+    TraceScope(Tracer *tracer, const char *name) : tracer_(tracer), name_(name)
+    {
+        if (tracer_)
+            start_time_ = std::chrono::steady_clock::now();
+    }
+
+    ~TraceScope()
+    {
+        if (tracer_)
+            tracer_->Complete(name_, start_time_);
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    Tracer *tracer_;
+    const char *name_;
+    std::chrono::steady_clock::time_point start_time_;
+};
+
+#endif
@@ -1,6 +1,9 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 #include "problem.h"
 #include "solution.h"
@@ -57,6 +60,44 @@ template <class T> auto CalcBestInsertion(const SpecificSolution &solution, cons
     return best_insertion;
 }
 
+// Sorts the values like std::stable_sort, merging through a buffer of the caller instead of a
+// temporary one, so the sort does not allocate once the buffer has grown.
+template <class T, class Compare> void StableSort(std::vector<T> &values, std::vector<T> &buffer, Compare compare)
+{
+    constexpr size_t kRunLength = 16;
+    size_t size = values.size();
+
+    // Insertion sort of short runs, then merges of runs of doubling length
+    for (size_t begin = 0; begin < size; begin += kRunLength)
+    {
+        size_t end = std::min(begin + kRunLength, size);
+        for (size_t i = begin + 1; i < end; ++i)
+        {
+            T value = std::move(values[i]);
+            size_t j = i;
+            for (; j > begin && compare(value, values[j - 1]); --j)
+                values[j] = std::move(values[j - 1]);
+            values[j] = std::move(value);
+        }
+    }
+
+    buffer.assign(values.begin(), values.end());
+    T *source = values.data();
+    T *destination = buffer.data();
+    for (size_t length = kRunLength; length < size; length *= 2)
+    {
+        for (size_t begin = 0; begin < size; begin += 2 * length)
+        {
+            size_t middle = std::min(begin + length, size);
+            size_t end = std::min(begin + 2 * length, size);
+            std::merge(source + begin, source + middle, source + middle, source + end, destination + begin, compare);
+        }
+        std::swap(source, destination);
+    }
+    if (source != values.data())
+        std::copy(source, source + size, values.data());
+}
+
 
 
 #endif
\ No newline at end of file
@@ -1,9 +1,38 @@
 #include <bits/stdc++.h>
 #include "include/distance_matrix_optimizer.h"
+#include "include/setup.h"
 #include "include/solver.h"
 
 using namespace std;
 
+// Print one line per operator, then the hit rate of every cache
+void PrintStatistics(const SearchStatistics &statistics)
+{
+    std::cout << std::endl << std::left << std::setw(16) << "Operator" << std::right << std::setw(12) << "Calls"
+              << std::setw(12) << "Improving" << std::setw(14) << "Improvement" << std::setw(12) << "Time (ms)"
+              << std::endl;
+    for (const auto *operators : {&statistics.inter_operators, &statistics.intra_operators})
+    {
+        for (const auto &op : *operators)
+        {
+            std::cout << std::left << std::setw(16) << op.name << std::right << std::setw(12) << op.num_calls
+                      << std::setw(12) << op.num_improvements << std::setw(14) << op.total_improvement
+                      << std::setw(12) << op.nanoseconds / 1000000 << std::endl;
+        }
+    }
+
+    std::cout << std::endl << std::left << std::setw(48) << "Cache" << std::right << std::setw(14) << "Hits"
+              << std::setw(14) << "Misses" << std::setw(10) << "Hit rate" << std::endl;
+    for (const auto &cache : statistics.caches)
+    {
+        double hit_rate = 100.0 * cache.hits / (cache.hits + cache.misses); // Only looked-up caches are listed
+        std::cout << std::left << std::setw(48) << cache.name << std::right << std::setw(14) << cache.hits
+                  << std::setw(14) << cache.misses << std::setw(9) << std::fixed << std::setprecision(1)
+                  << hit_rate << "%" << std::defaultfloat << std::endl;
+    }
+    std::cout << std::endl;
+}
+
 // Listener to track the solution process and print updates
 class SimpleListener : public Listener
 {
@@ -23,55 +52,182 @@ public:
             std::chrono::system_clock::now() - start_time_);
         std::cout << "End at " << elapsed_time.count() << "s: " << objective << std::endl;
     }
+    void OnStatistics(const SearchStatistics &statistics) override { PrintStatistics(statistics); }
 
 private:
     std::chrono::system_clock::time_point start_time_;
 };
 
-// Read problem data from a file
-Problem ReadProblemFromFile(const string &problem_path)
+// Listener that only keeps the statistics of the search, for a batch to print once all instances are solved
+class StatisticsListener : public Listener
 {
-    ifstream ifs(problem_path);
-    if (ifs.fail())
+public:
+    explicit StatisticsListener(SearchStatistics &statistics) : statistics_(statistics) {}
+    void OnStart() override {}
+    void OnUpdated([[maybe_unused]] const SpecificSolution &solution, [[maybe_unused]] int objective) override {}
+    void OnEnd([[maybe_unused]] const SpecificSolution &solution, [[maybe_unused]] int objective) override {}
+    void OnStatistics(const SearchStatistics &statistics) override { statistics_ = statistics; }
+
+private:
+    SearchStatistics &statistics_;
+};
+
+// Solve one instance and write its solution. Returns the objective of the solution.
+int SolveInstance(const string &problem_path, const string &output, int num_threads,
+                  unique_ptr<Listener> listener, bool collect_statistics = false, const string &trace_output = "")
+{
+    // Read problem and initialize solver
+    auto problem = ReadProblemFromFile(problem_path);
+    auto distance_matrix_optimizer = DistanceMatrixOptimizer(problem.distance_matrix);
+    SpecificSolver solver;
+    SpecificConfig config = MakeConfig(num_threads);
+    config.listener = std::move(listener);
+    config.collect_statistics = collect_statistics;
+    unique_ptr<Tracer> tracer;
+    if (!trace_output.empty())
     {
-        throw invalid_argument("Cannot open problem.");
+        tracer = make_unique<Tracer>();
+        config.tracer = tracer.get();
     }
 
-    Problem problem{};
-    ifs >> problem.num_customers >> problem.capacity;
-    ++problem.num_customers; // Adjust for 0-indexing
-    problem.demands.resize(problem.num_customers);
-
-    // Read demands for each customer
-    for (Node i = 1; i < problem.num_customers; ++i)
+    // Solve the problem and save the solution
+    auto solution = solver.Solve(config, problem);
+    int objective = solution.CalcObjective(problem);
+    distance_matrix_optimizer.Restore(solution);
+    ofstream ofs(output);
+    ofs << solution;
+    if (tracer)
     {
-        ifs >> problem.demands[i];
+        ofstream trace_ofs(trace_output);
+        tracer->WriteChromeTrace(trace_ofs);
     }
 
-    // Read customer locations and compute distances
-    vector<pair<int, int>> customers(problem.num_customers);
-    for (Node i = 0; i < problem.num_customers; ++i)
+    return objective;
+}
+
+// Result of one instance of a batch
+struct BatchResult
+{
+    string problem_path;
+    string output;
+    int objective = 0;
+    double seconds = 0;
+    string error; // Empty if the instance was solved
+    SearchStatistics statistics; // Collected with "--stats"
+};
+
+// Solve the instances on a pool of worker threads, one instance per worker at a time.
+// Every worker builds its own problem, distance matrix optimizer and configuration. The outputs are
+// named after the instance files, so two instances may not share a file name. Returns the exit code.
+int RunBatch(const vector<string> &problem_paths, int num_workers, bool collect_statistics, bool trace)
+{
+    set<string> stems;
+    for (const string &problem_path : problem_paths)
     {
-        ifs >> customers[i].first >> customers[i].second;
+        if (!stems.insert(filesystem::path(problem_path).stem().string()).second)
+        {
+            cerr << "Instance files must have distinct names, " << problem_path << " repeats one" << endl;
+            return 1;
+        }
     }
 
-    problem.distance_matrix.resize(problem.num_customers);
-    for (Node i = 0; i < problem.num_customers; ++i)
+    vector<BatchResult> results(problem_paths.size());
+    atomic<size_t> next_instance{0};
+    mutex output_mutex;
+
+    auto worker = [&]()
     {
-        problem.distance_matrix[i].resize(problem.num_customers);
-        for (Node j = 0; j < problem.num_customers; ++j)
+        for (size_t i = next_instance++; i < problem_paths.size(); i = next_instance++)
         {
-            auto [x1, y1] = customers[i];
-            auto [x2, y2] = customers[j];
-            problem.distance_matrix[i][j] = lround(hypot(x1 - x2, y1 - y2));
+            BatchResult &result = results[i];
+            result.problem_path = problem_paths[i];
+            string stem = filesystem::path(problem_paths[i]).stem().string();
+            result.output = "./output/solution_" + stem + ".txt";
+            string trace_output = trace ? "./output/trace_" + stem + ".json" : "";
+            unique_ptr<Listener> listener;
+            if (collect_statistics)
+                listener = make_unique<StatisticsListener>(result.statistics);
+
+            auto start_time = chrono::steady_clock::now();
+            try
+            {
+                // The workers already use all cores, so each solve runs a single search thread
+                result.objective = SolveInstance(result.problem_path, result.output, 1, std::move(listener),
+                                                 collect_statistics, trace_output);
+            }
+            catch (const exception &e)
+            {
+                result.error = e.what();
+            }
+            result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start_time).count();
+
+            lock_guard<mutex> lock(output_mutex);
+            cout << "Finished " << result.problem_path << endl;
         }
+    };
+
+    vector<thread> workers;
+    for (int i = 0; i < num_workers; ++i)
+        workers.emplace_back(worker);
+    for (auto &thread : workers)
+        thread.join();
+
+    // Print the summary table
+    cout << endl << left << setw(32) << "Instance" << right << setw(12) << "Objective" << setw(10)
+         << "Time (s)" << "  Output" << endl;
+    for (const auto &result : results)
+    {
+        cout << left << setw(32) << result.problem_path << right;
+        if (result.error.empty())
+            cout << setw(12) << result.objective << setw(10) << fixed << setprecision(2)
+                 << result.seconds << "  " << result.output << endl;
+        else
+            cout << setw(12) << "-" << setw(10) << "-" << "  " << result.error << endl;
     }
 
-    return problem;
+    // Print the statistics of every solved instance after the table, as the solves interleave
+    if (collect_statistics)
+    {
+        for (const auto &result : results)
+        {
+            if (!result.error.empty())
+                continue;
+            cout << endl << "Statistics of " << result.problem_path << endl;
+            PrintStatistics(result.statistics);
+        }
+    }
+    return 0;
 }
 
-int main()
-{   
+// Without instance files, solve the test cases data/SD<l>.txt to data/SD<r>.txt read from the standard
+// input, printing operator and cache statistics after each with "--stats". With "--trace", the phases of
+// each solve are written to output/trace<i>.json in Chrome trace-event format, to be opened in Perfetto.
+// With "[--workers <count>] <instance files>", solve the given files in parallel, printing the statistics
+// of each after the summary with "--stats" and writing the trace of each to output/trace_<name>.json.
+int main(int argc, char **argv)
+{
+    int num_workers = max(1u, thread::hardware_concurrency());
+    bool collect_statistics = false;
+    bool trace = false;
+    vector<string> problem_paths;
+    for (int i = 1; i < argc; ++i)
+    {
+        string argument = argv[i];
+        if (argument == "--workers" && i + 1 < argc)
+            num_workers = max(1, atoi(argv[++i]));
+        else if (argument == "--stats")
+            collect_statistics = true;
+        else if (argument == "--trace")
+            trace = true;
+        else
+            problem_paths.push_back(argument);
+    }
+
+    if (!problem_paths.empty())
+    {
+        return RunBatch(problem_paths, num_workers, collect_statistics, trace);
+    }
+
     // Get range of test cases to process
     int l, r;
     cin >> l >> r;
@@ -89,65 +245,10 @@ int main()
         cout << "Problem file: " << problem_path << endl;
         cout << "Output file: " << output << endl;
 
-        // Read problem and initialize solver
-        auto problem = ReadProblemFromFile(problem_path);
-        auto distance_matrix_optimizer = DistanceMatrixOptimizer(problem.distance_matrix);
-        SpecificSolver solver;
-        SpecificConfig config;
-
-        config.random_seed = 42;
-        config.time_limit = 10;
-        config.blink_rate = 0.021;
-
-        // Add operators for optimization
-        config.inter_operators.push_back(make_unique<Relocate>());
-        config.inter_operators.push_back(make_unique<Swap<2, 0>>());
-        config.inter_operators.push_back(make_unique<Swap<2, 1>>());
-        config.inter_operators.push_back(make_unique<Swap<2, 2>>());
-        config.inter_operators.push_back(make_unique<Cross>());
-        config.inter_operators.push_back(make_unique<SwapStar>());
-        config.inter_operators.push_back(make_unique<SdSwapStar>());
-        config.inter_operators.push_back(make_unique<SdSwapOneOne>());
-        config.inter_operators.push_back(make_unique<SdSwapTwoOne>());
-
-        config.intra_operators.push_back(std::make_unique<Exchange>());
-        config.intra_operators.push_back(std::make_unique<OrOpt<1>>());
-        config.intra_operators.push_back(std::make_unique<OrOpt<2>>());
-        config.intra_operators.push_back(std::make_unique<OrOpt<3>>());
-
-        // Configure acceptance rule
-        auto length = static_cast<int>(83);
-        config.acceptance_rule = [length]()
-        {
-            return std::make_unique<LateAcceptanceHillClimbing>(length);
-        };
-
-        // Configure ruin and recreate method
-        auto average_customers = static_cast<int>(36);
-        auto max_length = static_cast<int>(8);
-        auto split_rate = 0.740;
-        auto preserved_probability = 0.096;
-
-        config.ruin_method = make_unique<SisrsRuin>(average_customers, max_length,
-                                                    split_rate, preserved_probability);
-
-        // Configure sorting
-        Sorter sorter;
-        sorter.AddSortFunction(std::make_unique<SortByRandom>(), 0.078);
-        sorter.AddSortFunction(std::make_unique<SortByDemand>(), 0.225);
-        sorter.AddSortFunction(std::make_unique<SortByFar>(), 0.942);
-        sorter.AddSortFunction(std::make_unique<SortByClose>(), 0.120);
-
-        config.sorter = std::move(sorter);
-
-        // Set up listener
-        config.listener = std::move(std::make_unique<SimpleListener>());
-
-        // Solve the problem and save the solution
-        auto solution = solver.Solve(config, problem);
-        distance_matrix_optimizer.Restore(solution);
-        ofstream ofs(output);
-        ofs << solution;
+        int num_threads = max(1u, thread::hardware_concurrency()); // One restart per core
+        string trace_output = trace ? "./output/trace" + to_string(i) + ".json" : "";
+        SolveInstance(problem_path, output, num_threads, std::make_unique<SimpleListener>(), collect_statistics,
+                      trace_output);
     }
 
     return 0;
@@ -2,6 +2,8 @@
 
 #include <cmath>
 
+#include "../include/random_engine.h"
+
 /* These functions can be used as acceptance rules. Currently, only LAHC is being
    used in the algorithm .*/
 
@@ -27,7 +29,7 @@ bool LateAcceptanceHillClimbing::Accept(int old_value, int new_value) {
 }
 
 bool SimulatedAnnealing::Accept(int old_value, int new_value) {
-    float r = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
+    double r = ThreadRandom().Uniform();
     bool accepted = new_value <= old_value || r < exp((old_value - new_value) / temperature_);
     temperature_ *= decay_;
     return accepted;
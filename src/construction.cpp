@@ -1,6 +1,6 @@
 #include "../include/construction.h"
 #include <vector>
-#include <random>
+#include "../include/random_engine.h"
 
 #include "../include/route_context.h"
 #include "../include/utils.h"
@@ -23,7 +23,7 @@ int AddRoute(CandidateList &candidateList, SpecificSolution &solution,
                RouteContext &context) 
 {
     int range = candidateList.size();
-    int position = rand() % range;
+    int position = ThreadRandom().Below(range);
 
     auto [customer, demand] = candidateList[position];
     Node node_index = solution.Insert(customer, demand, 0, 0);
@@ -203,7 +203,7 @@ template <class Func> void InsertCandidates(const Problem &problem, const Func &
                         CandidateList &candidate_list, SpecificSolution &solution, 
                         RouteContext &context) 
 {
-    int strategy = rand() % 2;
+    int strategy = ThreadRandom().Below(2);
 
     if (strategy == 0)
         SequentialInsertion(problem, func, candidate_list, solution, context); // Perform sequential insertion
@@ -233,28 +233,28 @@ SpecificSolution Construct(const Problem& problem)
     }
 
     SpecificSolution solution; // Solution to be returned
-    RouteContext context; // Details about the routes decided
+    RouteContext context(problem); // Details about the routes decided
 
     // Add some initial routes
     for (Node i = 0; i < num_fleets && !candidate_list.empty(); ++i)
       AddRoute(candidate_list, solution, context);
     
-    int criterion = rand() % 2; // Randomly decide the insertion criterion
+    int criterion = ThreadRandom().Below(2); // Randomly decide the insertion criterion
     
     // MCFIC criteria
     if (criterion == 0) 
     {
-        float gamma = static_cast<float>(rand() % 35) * 0.05f; // Randomly select gamma
+        float gamma = static_cast<float>(ThreadRandom().Below(35)) * 0.05f; // Randomly select gamma
       
         // Cost function of MCFIC
         auto func = [&](Node predecessor, Node successor, Node customer) {
             Node pre_customer = solution.Customer(predecessor);
             Node suc_customer = solution.Customer(successor);
 
-            return static_cast<float>(problem.distance_matrix[pre_customer][customer]
-                                    + problem.distance_matrix[customer][suc_customer]
-                                    - problem.distance_matrix[pre_customer][suc_customer])
-                - 2 * gamma * problem.distance_matrix[0][customer];
+            return static_cast<float>(problem.distance_matrix(pre_customer, customer)
+                                    + problem.distance_matrix(customer, suc_customer)
+                                    - problem.distance_matrix(pre_customer, suc_customer))
+                - 2 * gamma * problem.distance_matrix(0, customer);
         };
       
         InsertCandidates(problem, func, candidate_list, solution, context); // Insert candidates
@@ -271,7 +271,7 @@ SpecificSolution Construct(const Problem& problem)
                 return std::numeric_limits<float>::max();
              
             else
-                return static_cast<float>(problem.distance_matrix[pre_customer][customer]);  
+                return static_cast<float>(problem.distance_matrix(pre_customer, customer));  
         };
       
         InsertCandidates(problem, func, candidate_list, solution, context); // Insert candidates
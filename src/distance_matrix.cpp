@@ -0,0 +1,72 @@
+#include "../include/distance_matrix.h"
+
+#include <limits>
+#include <stdexcept>
+
+// Build the matrix from a square matrix of distances
+DistanceMatrix::DistanceMatrix(const std::vector<std::vector<int>> &distances, bool upper_triangle)
+    : size_(static_cast<int>(distances.size())), upper_triangle_(upper_triangle)
+{
+    // Use 16-bit elements if every distance fits
+    bool narrow = true;
+    for (int i = 0; i < size_; ++i)
+    {
+        for (int j = 0; j < size_; ++j)
+        {
+            if (distances[i][j] < 0 || distances[i][j] > std::numeric_limits<uint16_t>::max())
+                narrow = false;
+            if (upper_triangle && distances[i][j] != distances[j][i])
+                throw std::invalid_argument("Only a symmetric distance matrix can be stored as a triangle.");
+        }
+    }
+    shift_ = narrow ? 1 : 2;
+    mask_ = narrow ? 0xffffu : 0xffffffffu;
+
+    size_t num_elements;
+    if (upper_triangle_)
+    {
+        // Row i holds the elements (i, i) to (i, size - 1)
+        row_offsets_.resize(size_);
+        size_t offset = 0;
+        for (int i = 0; i < size_; ++i)
+        {
+            row_offsets_[i] = offset - i;
+            offset += size_ - i;
+        }
+        num_elements = offset;
+    }
+    else
+    {
+        size_t elements_per_line = CacheAlignedAllocator<unsigned char>::kAlignment >> shift_;
+        stride_ = (size_ + elements_per_line - 1) / elements_per_line * elements_per_line;
+        num_elements = stride_ * size_;
+    }
+
+    // The padding lets the last element be read with a 32-bit load
+    data_.assign((num_elements << shift_) + sizeof(uint32_t), 0);
+
+    for (int i = 0; i < size_; ++i)
+    {
+        for (int j = upper_triangle_ ? i : 0; j < size_; ++j)
+            Set(i, j, distances[i][j]);
+    }
+}
+
+// Set the distance between i and j
+void DistanceMatrix::Set(int i, int j, int distance)
+{
+    unsigned char *element = data_.data() + (Offset(i, j) << shift_);
+    if (IsNarrow())
+    {
+        if (distance < 0 || distance > std::numeric_limits<uint16_t>::max())
+            throw std::out_of_range("Distance does not fit in the 16-bit distance matrix.");
+
+        uint16_t value = static_cast<uint16_t>(distance);
+        std::memcpy(element, &value, sizeof(value));
+    }
+    else
+    {
+        int32_t value = distance;
+        std::memcpy(element, &value, sizeof(value));
+    }
+}
@@ -3,22 +3,24 @@
 
 // Constructor that optimizes the distance matrix using the Floyd-Warshall algorithm.
 // Also keeps track of intermediate nodes for path restoration.
-DistanceMatrixOptimizer::DistanceMatrixOptimizer(std::vector<std::vector<int>> &distance_matrix) 
-    : original_(distance_matrix), previous_node_indices_(distance_matrix.size(), std::vector<Node>(distance_matrix.size()))
+DistanceMatrixOptimizer::DistanceMatrixOptimizer(DistanceMatrix &distance_matrix) 
+    : original_(distance_matrix), previous_node_indices_(distance_matrix.Size(), std::vector<Node>(distance_matrix.Size()))
 {
-    Node num_customers = static_cast<Node>(distance_matrix.size());
+    Node num_customers = static_cast<Node>(distance_matrix.Size());
     for (Node k = 1; k < num_customers; ++k)
     {
         for (Node i = 0; i < num_customers; ++i)
         {
             for (Node j = 0; j < num_customers; ++j)
             {
-                int distance = distance_matrix[i][k] + distance_matrix[k][j];
+                int distance = distance_matrix(i, k) + distance_matrix(k, j);
                 // Update to shorter path if a better route is found
-                if (distance_matrix[i][j] > distance)
+                if (distance_matrix(i, j) > distance)
                 {
-                    distance_matrix[i][j] = distance;
+                    distance_matrix.Set(i, j, distance);
                     previous_node_indices_[i][j] = k; // Record the intermediate node
+                    if (distance_matrix.IsUpperTriangle())
+                        previous_node_indices_[j][i] = k; // (j, i) shares the element with (i, j)
                 }
             }
         }
@@ -0,0 +1,184 @@
+#include "../include/insertion_kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define INSERTION_KERNEL_X86
+#endif
+
+namespace
+{
+
+using CollectFunction = int (*)(const DistanceMatrix &, Node, Node, Node, const int *, Node *, int *);
+
+// Scalar scan of the customers [first, num_customers)
+int CollectScalar(const DistanceMatrix &distance_matrix, Node predecessor, Node successor,
+                  Node num_customers, const int *thresholds, Node *customers, int *deltas, Node first,
+                  int count)
+{
+    int distance = distance_matrix(predecessor, successor);
+    for (Node customer = first; customer < num_customers; ++customer)
+    {
+        int delta = distance_matrix(predecessor, customer) + distance_matrix(successor, customer) - distance;
+        if (delta <= thresholds[customer])
+        {
+            customers[count] = customer;
+            deltas[count++] = delta;
+        }
+    }
+    return count;
+}
+
+int CollectScalar(const DistanceMatrix &distance_matrix, Node predecessor, Node successor,
+                  Node num_customers, const int *thresholds, Node *customers, int *deltas)
+{
+    return CollectScalar(distance_matrix, predecessor, successor, num_customers, thresholds, customers,
+                         deltas, 1, 0);
+}
+
+#ifdef INSERTION_KERNEL_X86
+
+// Append the lanes selected by mask, lowest lane first
+inline int Emit(unsigned mask, const int *lane_deltas, Node first, Node *customers, int *deltas, int count)
+{
+    while (mask)
+    {
+        int lane = __builtin_ctz(mask);
+        customers[count] = static_cast<Node>(first + lane);
+        deltas[count++] = lane_deltas[lane];
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+// Lanes of delta that do not exceed their thresholds
+__attribute__((target("avx2"))) inline unsigned SelectAvx2(__m256i delta, const int *thresholds,
+                                                           int *lane_deltas)
+{
+    __m256i threshold = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(thresholds));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lane_deltas), delta);
+    __m256i greater = _mm256_cmpgt_epi32(delta, threshold);
+    return ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(greater))) & 0xffu;
+}
+
+// Eight customers per step
+__attribute__((target("avx2"))) int CollectAvx2(const DistanceMatrix &distance_matrix, Node predecessor,
+                                                Node successor, Node num_customers,
+                                                const int *thresholds, Node *customers, int *deltas)
+{
+    __m256i base = _mm256_set1_epi32(-distance_matrix(predecessor, successor));
+    int lane_deltas[8];
+    int count = 0;
+    Node customer = 1;
+    if (distance_matrix.IsNarrow())
+    {
+        const uint16_t *predecessor_row = distance_matrix.NarrowRow(predecessor);
+        const uint16_t *successor_row = distance_matrix.NarrowRow(successor);
+        for (; customer + 8 <= num_customers; customer += 8)
+        {
+            __m256i a = _mm256_cvtepu16_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(predecessor_row + customer)));
+            __m256i b = _mm256_cvtepu16_epi32(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(successor_row + customer)));
+            __m256i delta = _mm256_add_epi32(_mm256_add_epi32(a, b), base);
+            unsigned mask = SelectAvx2(delta, thresholds + customer, lane_deltas);
+            count = Emit(mask, lane_deltas, customer, customers, deltas, count);
+        }
+    }
+    else
+    {
+        const int32_t *predecessor_row = distance_matrix.WideRow(predecessor);
+        const int32_t *successor_row = distance_matrix.WideRow(successor);
+        for (; customer + 8 <= num_customers; customer += 8)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(predecessor_row + customer));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(successor_row + customer));
+            __m256i delta = _mm256_add_epi32(_mm256_add_epi32(a, b), base);
+            unsigned mask = SelectAvx2(delta, thresholds + customer, lane_deltas);
+            count = Emit(mask, lane_deltas, customer, customers, deltas, count);
+        }
+    }
+    return CollectScalar(distance_matrix, predecessor, successor, num_customers, thresholds, customers,
+                         deltas, customer, count);
+}
+
+// Lanes of delta that do not exceed their thresholds
+__attribute__((target("avx512f"))) inline unsigned SelectAvx512(__m512i delta, const int *thresholds,
+                                                                int *lane_deltas)
+{
+    __m512i threshold = _mm512_loadu_si512(thresholds);
+    _mm512_storeu_si512(lane_deltas, delta);
+    return _mm512_cmple_epi32_mask(delta, threshold);
+}
+
+// Sixteen customers per step
+__attribute__((target("avx512f"))) int CollectAvx512(const DistanceMatrix &distance_matrix,
+                                                     Node predecessor, Node successor,
+                                                     Node num_customers, const int *thresholds,
+                                                     Node *customers, int *deltas)
+{
+    __m512i base = _mm512_set1_epi32(-distance_matrix(predecessor, successor));
+    int lane_deltas[16];
+    int count = 0;
+    Node customer = 1;
+    if (distance_matrix.IsNarrow())
+    {
+        const uint16_t *predecessor_row = distance_matrix.NarrowRow(predecessor);
+        const uint16_t *successor_row = distance_matrix.NarrowRow(successor);
+        // The zero-masked widening avoids reading an undefined vector in the unmasked intrinsic
+        for (; customer + 16 <= num_customers; customer += 16)
+        {
+            __m512i a = _mm512_maskz_cvtepu16_epi32(
+                0xffff, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(predecessor_row + customer)));
+            __m512i b = _mm512_maskz_cvtepu16_epi32(
+                0xffff, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(successor_row + customer)));
+            __m512i delta = _mm512_add_epi32(_mm512_add_epi32(a, b), base);
+            unsigned mask = SelectAvx512(delta, thresholds + customer, lane_deltas);
+            count = Emit(mask, lane_deltas, customer, customers, deltas, count);
+        }
+    }
+    else
+    {
+        const int32_t *predecessor_row = distance_matrix.WideRow(predecessor);
+        const int32_t *successor_row = distance_matrix.WideRow(successor);
+        for (; customer + 16 <= num_customers; customer += 16)
+        {
+            __m512i a = _mm512_loadu_si512(predecessor_row + customer);
+            __m512i b = _mm512_loadu_si512(successor_row + customer);
+            __m512i delta = _mm512_add_epi32(_mm512_add_epi32(a, b), base);
+            unsigned mask = SelectAvx512(delta, thresholds + customer, lane_deltas);
+            count = Emit(mask, lane_deltas, customer, customers, deltas, count);
+        }
+    }
+    return CollectScalar(distance_matrix, predecessor, successor, num_customers, thresholds, customers,
+                         deltas, customer, count);
+}
+
+#endif
+
+// Pick the widest kernel supported by the CPU
+CollectFunction SelectKernel()
+{
+#ifdef INSERTION_KERNEL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return CollectAvx512;
+    if (__builtin_cpu_supports("avx2"))
+        return CollectAvx2;
+#endif
+    return CollectScalar;
+}
+
+const CollectFunction kCollect = SelectKernel();
+
+} // namespace
+
+int CollectInsertionCandidates(const DistanceMatrix &distance_matrix, Node predecessor, Node successor,
+                               Node num_customers, const int *thresholds, Node *customers, int *deltas)
+{
+    // Rows of the upper triangle layout are not contiguous
+    if (distance_matrix.IsUpperTriangle())
+        return CollectScalar(distance_matrix, predecessor, successor, num_customers, thresholds, customers,
+                             deltas);
+
+    return kCollect(distance_matrix, predecessor, successor, num_customers, thresholds, customers, deltas);
+}
@@ -55,11 +55,32 @@ using namespace std;
   // - route_x: First route index
   // - route_y: Second route index
   // - cache: Cache to store the best move
+  // - neighbors: Granular neighborhoods restricting the new edges
   void CrossInner(const Problem& problem, const SpecificSolution &solution, const RouteContext &context,
-                  Node route_x, Node route_y, BaseCache<CrossMove> &cache) {
+                  Node route_x, Node route_y, BaseCache<CrossMove> &cache,
+                  const NeighborLists &neighbors) {
+    static thread_local CandidateNodes cuts_y; // Cuts of route y after a node, for a cut of route x
+    int length_y = context.Length(route_y);
     Node left_x = 0;
     do {
       Node successor_x = left_x ? solution.Successor(left_x) : context.Head(route_x);
+      // Cuts of x at the depot connect to it, so every cut of y is in the neighborhood
+      if (!left_x || !successor_x
+          || !EnumerateNeighborVisits(neighbors, length_y,
+                                      {solution.Customer(left_x), solution.Customer(successor_x)})) {
+        cuts_y.Scan(context.Head(route_y));
+      } else {
+        // Cuts of y at the depot or next to a neighbor of the nodes around the cut of x
+        cuts_y.Collect(solution.MaxNodeIndex());
+        cuts_y.Add(context.Tail(route_y));
+        for (Node customer : {solution.Customer(left_x), solution.Customer(successor_x)}) {
+          ForEachNeighborVisit(solution, context, neighbors, customer, route_y, [&](Node node_index) {
+            cuts_y.Add(node_index);
+            cuts_y.Add(solution.Predecessor(node_index));
+          });
+        }
+      }
+      // The cut before the head comes first
       Node left_y = 0;
       do {
         Node predecessor_y = left_y;
@@ -69,17 +90,18 @@ using namespace std;
         int predecessor_load_y = context.PreLoad(left_y);
         int successor_load_y = context.Load(route_y) - predecessor_load_y;
         int base
-            = -problem.distance_matrix[solution.Customer(left_x)][solution.Customer(successor_x)]
-              - problem.distance_matrix[solution.Customer(left_y)][solution.Customer(successor_y)];
+            = -problem.distance_matrix(solution.Customer(left_x), solution.Customer(successor_x))
+              - problem.distance_matrix(solution.Customer(left_y), solution.Customer(successor_y));
         for (bool reversed : {false, true}) {
           if (predecessor_load_x + successor_load_y <= problem.capacity
-              && successor_load_x + predecessor_load_y <= problem.capacity) {
+              && successor_load_x + predecessor_load_y <= problem.capacity
+              && (neighbors.IsNeighbor(solution.Customer(left_x), solution.Customer(successor_y))
+                  || neighbors.IsNeighbor(solution.Customer(successor_x),
+                                          solution.Customer(predecessor_y)))) {
             int delta
                 = base
-                  + problem
-                        .distance_matrix[solution.Customer(left_x)][solution.Customer(successor_y)]
-                  + problem.distance_matrix[solution.Customer(successor_x)]
-                                           [solution.Customer(predecessor_y)];
+                  + problem.distance_matrix(solution.Customer(left_x), solution.Customer(successor_y))
+                  + problem.distance_matrix(solution.Customer(successor_x), solution.Customer(predecessor_y));
             if (cache.delta.Update(delta)) {
               cache.move = {reversed, route_x, route_y, left_x, left_y};
             }
@@ -87,7 +109,7 @@ using namespace std;
           std::swap(predecessor_y, successor_y);
           std::swap(predecessor_load_y, successor_load_y);
         }
-        left_y = successor_y;
+        left_y = left_y ? cuts_y.Next(solution, left_y) : cuts_y.First();
       } while (left_y);
       left_x = successor_x;
     } while (left_x);
@@ -99,18 +121,30 @@ using namespace std;
   // - solution: Current solution to be modified
   // - context: Route context tracking route-specific information
   // - cache_map: Cache management for move calculations
-  // Returns: Vector of modified route indices
-  vector<Node> Cross::operator()(const Problem& problem, SpecificSolution &solution,
-                                                      RouteContext &context,
-                                                      CacheMap &cache_map) const {
+  // - search: Granular neighborhoods and the pool evaluating the route pairs
+  // Returns: The best move, applied by the caller if it improves the solution
+  InterMove Cross::Evaluate(const Problem& problem, const SpecificSolution &solution,
+                                                      const RouteContext &context,
+                                                      CacheMap &cache_map,
+                                                      const SearchContext &search) const {
     auto &caches = cache_map.Get<InterRouteCache<CrossMove>>(solution, context);
+    if (search.pool) {
+      EvaluateInvalidatedPairs(*search.pool, search.stopping, caches, context.NumRoutes(), false,
+                               [&](Node route_x, Node route_y, BaseCache<CrossMove> &cache) {
+                                 CrossInner(problem, solution, context, route_x, route_y, cache,
+                                            search.neighbors);
+                               });
+    }
     CrossMove best_move{};
     Delta<int> best_delta{};
     for (Node route_x = 0; route_x < context.NumRoutes(); ++route_x) {
+      if (search.IsCancelled()) {
+        return {};
+      }
       for (Node route_y = route_x + 1; route_y < context.NumRoutes(); ++route_y) {
         auto &cache = caches.Get(route_x, route_y);
-        if (!cache.TryReuse()) {
-          CrossInner(problem, solution, context, route_x, route_y, cache);
+        if (!caches.TryReuse(cache, !search.pool)) {
+          CrossInner(problem, solution, context, route_x, route_y, cache, search.neighbors);
         } else {
           cache.move.route_x = route_x;
           cache.move.route_y = route_y;
@@ -120,9 +154,20 @@ using namespace std;
         }
       }
     }
-    if (best_delta.value < 0) {
-      DoCross(best_move, solution, context);
-      return {best_move.route_x, best_move.route_y};
+    // The best move is applied by the caller if it improves the solution
+    if (best_delta.value >= 0) {
+      return {};
     }
-    return {};
+    caches.best_move = best_move;
+    return {best_delta, [&caches](SpecificSolution &solution, RouteContext &context) {
+              DoCross(caches.best_move, solution, context);
+              return ModifiedRoutes{caches.best_move.route_x, caches.best_move.route_y};
+            }};
+  }
+
+  // Creates the cache of the operator
+  void Cross::Prepare([[maybe_unused]] const Problem &problem, const SpecificSolution &solution,
+                      const RouteContext &context, CacheMap &cache_map,
+                      [[maybe_unused]] const SearchContext &search) const {
+    cache_map.Get<InterRouteCache<CrossMove>>(solution, context);
   }
\ No newline at end of file
@@ -36,20 +36,29 @@
   // - route_y: Destination route index
   // - cache: Cache to store the best move
   // - star_caches: Star-based caches for efficient insertion point finding
+  // - neighbors: Granular neighborhoods restricting the insertion points
   void RelocateInner(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
                      Node route_x, Node route_y, BaseCache<RelocateMove> &cache,
-                     StarCaches &star_caches) {
+                     StarCaches &star_caches, const NeighborLists &neighbors) {
     star_caches.Preprocess(problem, solution, context, route_y);
     Node node_x = context.Head(route_x);
     while (node_x) {
       if (context.Load(route_y) + solution.Load(node_x) <= problem.capacity) {
-        auto insertion = star_caches.Get(route_y, solution.Customer(node_x)).FindBest();
-        Node predecessor_x = solution.Predecessor(node_x);
-        Node successor_x = solution.Successor(node_x);
-        int delta = insertion->delta.value
-                    - CalcDelta(problem, solution, node_x, predecessor_x, successor_x);
-        if (cache.delta.Update(delta)) {
-          cache.move = {route_x, route_y, node_x, insertion->predecessor, insertion->successor};
+        Node customer_x = solution.Customer(node_x);
+        // The best of the cached insertions next to a neighbor
+        auto insertion = star_caches.Get(route_y, customer_x).FindBestIf([&](const Insertion &candidate) {
+          return neighbors.IsNeighborInsertion(customer_x, customer_x,
+                                               solution.Customer(candidate.predecessor),
+                                               solution.Customer(candidate.successor));
+        });
+        if (insertion) {
+          Node predecessor_x = solution.Predecessor(node_x);
+          Node successor_x = solution.Successor(node_x);
+          int delta = insertion->delta.value
+                      - CalcDelta(problem, solution, node_x, predecessor_x, successor_x);
+          if (cache.delta.Update(delta)) {
+            cache.move = {route_x, route_y, node_x, insertion->predecessor, insertion->successor};
+          }
         }
       }
       node_x = solution.Successor(node_x);
@@ -62,22 +71,39 @@
   // - solution: Current solution to be modified
   // - context: Route context tracking route-specific information
   // - cache_map: Cache management for move calculations
-  // Returns: Vector of modified route indices
-  std::vector<Node> Relocate::operator()(const Problem &problem, SpecificSolution &solution,
-                                                         RouteContext &context,
-                                                         CacheMap &cache_map) const {
+  // - search: Granular neighborhoods and the pool evaluating the route pairs
+  // Returns: The best move, applied by the caller if it improves the solution
+  InterMove Relocate::Evaluate(const Problem &problem, const SpecificSolution &solution,
+                                                         const RouteContext &context,
+                                                         CacheMap &cache_map,
+                                                         const SearchContext &search) const {
     auto &caches = cache_map.Get<InterRouteCache<RelocateMove>>(solution, context);
     auto &star_caches = cache_map.Get<StarCaches>(solution, context);
+    if (search.pool) {
+      EvaluateInvalidatedPairs(
+          *search.pool, search.stopping, caches, context.NumRoutes(), true, [](Node, Node) { return true; },
+          [&](const RoutePairs &pairs) {
+            star_caches.Preprocess(problem, solution, context, pairs, *search.pool, search.stopping);
+          },
+          [&](Node route_x, Node route_y, BaseCache<RelocateMove> &cache) {
+            RelocateInner(problem, solution, context, route_x, route_y, cache, star_caches,
+                          search.neighbors);
+          });
+    }
     RelocateMove best_move{};
     Delta<int> best_delta{};
     for (Node route_x = 0; route_x < context.NumRoutes(); ++route_x) {
+      if (search.IsCancelled()) {
+        return {};
+      }
       for (Node route_y = 0; route_y < context.NumRoutes(); ++route_y) {
         if (route_x == route_y) {
           continue;
         }
         auto &cache = caches.Get(route_x, route_y);
-        if (!cache.TryReuse()) {
-          RelocateInner(problem, solution, context, route_x, route_y, cache, star_caches);
+        if (!caches.TryReuse(cache, !search.pool)) {
+          RelocateInner(problem, solution, context, route_x, route_y, cache, star_caches,
+                        search.neighbors);
         } else {
           cache.move.route_x = route_x;
           cache.move.route_y = route_y;
@@ -87,10 +113,22 @@
         }
       }
     }
-    // If an improvement is found, perform the relocate move
-    if (best_delta.value < 0) {
-      DoRelocate(best_move, solution, context);
-      return {best_move.route_x, best_move.route_y};
+    // The best move is applied by the caller if it improves the solution
+    if (best_delta.value >= 0) {
+      return {};
     }
-    return {};
+    caches.best_move = best_move;
+    return {best_delta, [&caches](SpecificSolution &solution, RouteContext &context) {
+              DoRelocate(caches.best_move, solution, context);
+              return ModifiedRoutes{caches.best_move.route_x, caches.best_move.route_y};
+            }};
+  }
+
+  // Creates the caches of the operator and prepares the insertion caches of all routes
+  void Relocate::Prepare(const Problem &problem, const SpecificSolution &solution,
+                         const RouteContext &context, CacheMap &cache_map,
+                         const SearchContext &search) const {
+    cache_map.Get<InterRouteCache<RelocateMove>>(solution, context);
+    cache_map.Get<StarCaches>(solution, context).PreprocessAll(problem, solution, context, search.pool,
+                                                                          search.stopping);
   }
\ No newline at end of file
@@ -38,11 +38,21 @@ void DoSdSwapOneOne(const SdSwapOneOneMove &move, SpecificSolution &solution, Ro
 void SdSwapOneOneInner(const Problem &problem, const SpecificSolution &solution,
                         [[maybe_unused]] const RouteContext &context, bool swapped, Node route_x,
                         Node route_y, Node node_x, Node node_y, int split_load,
-                        BaseCache<SdSwapOneOneMove> &cache) {
+                        BaseCache<SdSwapOneOneMove> &cache, const NeighborLists &neighbors) {
   Node predecessor_x = solution.Predecessor(node_x);
   Node successor_x = solution.Successor(node_x);
   Node predecessor_y = solution.Predecessor(node_y);
   Node successor_y = solution.Successor(node_y);
+  // A visit of x takes the place of y, and y is inserted next to x
+  Node customer_x = solution.Customer(node_x);
+  Node customer_y = solution.Customer(node_y);
+  if (!neighbors.IsNeighborInsertion(customer_x, customer_x, solution.Customer(predecessor_y),
+                                     solution.Customer(successor_y))
+      && !neighbors.IsNeighbor(customer_y, customer_x)
+      && !neighbors.IsNeighborInsertion(customer_y, customer_y, solution.Customer(predecessor_x),
+                                        solution.Customer(successor_x))) {
+    return;
+  }
   int delta = -CalcDelta(problem, solution, node_y, predecessor_y, successor_y);
   int delta_x = CalcDelta(problem, solution, node_x, predecessor_y, successor_y);
   int before = CalcDelta(problem, solution, node_y, predecessor_x, node_x);
@@ -69,17 +79,43 @@ void SdSwapOneOneInner(const Problem &problem, const SpecificSolution &solution,
 // Overloaded inner function to iterate through nodes in two routes
 void SdSwapOneOneInner(const Problem &problem, const SpecificSolution &solution,
                         const RouteContext &context, Node route_x, Node route_y,
-                        BaseCache<SdSwapOneOneMove> &cache) {
+                        BaseCache<SdSwapOneOneMove> &cache, const NeighborLists &neighbors) {
+  static thread_local CandidateNodes nodes_y; // Nodes of route y paired with a node of route x
+  int length_y = context.Length(route_y);
   for (Node node_x = context.Head(route_x); node_x; node_x = solution.Successor(node_x)) {
     int load_x = solution.Load(node_x);
-    for (Node node_y = context.Head(route_y); node_y; node_y = solution.Successor(node_y)) {
+    Node predecessor_x = solution.Predecessor(node_x);
+    Node successor_x = solution.Successor(node_x);
+    // Nodes of x next to the depot connect nodes of y to it, so every node of y is in the neighborhood
+    if (!predecessor_x || !successor_x
+        || !EnumerateNeighborVisits(neighbors, length_y,
+                                    {solution.Customer(node_x), solution.Customer(predecessor_x),
+                                     solution.Customer(successor_x)})) {
+      nodes_y.Scan(context.Head(route_y));
+    } else {
+      // Nodes of y at the ends of the route, next to or neighbors of x, or neighbors of the nodes
+      // around x
+      nodes_y.Collect(solution.MaxNodeIndex());
+      nodes_y.Add(context.Head(route_y));
+      nodes_y.Add(context.Tail(route_y));
+      ForEachNeighborVisit(solution, context, neighbors, solution.Customer(node_x), route_y, [&](Node node_index) {
+        nodes_y.Add(node_index);
+        nodes_y.Add(solution.Predecessor(node_index));
+        nodes_y.Add(solution.Successor(node_index));
+      });
+      for (Node customer : {solution.Customer(predecessor_x), solution.Customer(successor_x)}) {
+        ForEachNeighborVisit(solution, context, neighbors, customer, route_y,
+                             [&](Node node_index) { nodes_y.Add(node_index); });
+      }
+    }
+    for (Node node_y = nodes_y.First(); node_y; node_y = nodes_y.Next(solution, node_y)) {
       int load_y = solution.Load(node_y);
       if (load_x > load_y) {
         SdSwapOneOneInner(problem, solution, context, false, route_x, route_y, node_x, node_y,
-                          load_x - load_y, cache);
+                          load_x - load_y, cache, neighbors);
       } else if (load_y > load_x) {
         SdSwapOneOneInner(problem, solution, context, true, route_y, route_x, node_y, node_x,
-                          load_y - load_x, cache);
+                          load_y - load_x, cache, neighbors);
       }
     }
   }
@@ -87,18 +123,29 @@ void SdSwapOneOneInner(const Problem &problem, const SpecificSolution &solution,
 
 // Main operator function implementing the Split Delivery Swap One-One Move
 // This function finds and applies the best route modification
-std::vector<Node> SdSwapOneOne::operator()(const Problem &problem,
-                                                            SpecificSolution &solution,
-                                                            RouteContext &context,
-                                                            CacheMap &cache_map) const {
+InterMove SdSwapOneOne::Evaluate(const Problem &problem,
+                                                            const SpecificSolution &solution,
+                                                            const RouteContext &context,
+                                                            CacheMap &cache_map,
+                                                            const SearchContext &search) const {
   auto &caches = cache_map.Get<InterRouteCache<SdSwapOneOneMove>>(solution, context);
+  if (search.pool) {
+    EvaluateInvalidatedPairs(*search.pool, search.stopping, caches, context.NumRoutes(), false,
+                             [&](Node route_x, Node route_y, BaseCache<SdSwapOneOneMove> &cache) {
+                               SdSwapOneOneInner(problem, solution, context, route_x, route_y, cache,
+                                                 search.neighbors);
+                             });
+  }
   SdSwapOneOneMove best_move{};
   Delta<int> best_delta{};
   for (Node route_x = 0; route_x < context.NumRoutes(); ++route_x) {
+    if (search.IsCancelled()) {
+      return {};
+    }
     for (Node route_y = route_x + 1; route_y < context.NumRoutes(); ++route_y) {
       auto &cache = caches.Get(route_x, route_y);
-      if (!cache.TryReuse()) {
-        SdSwapOneOneInner(problem, solution, context, route_x, route_y, cache);
+      if (!caches.TryReuse(cache, !search.pool)) {
+        SdSwapOneOneInner(problem, solution, context, route_x, route_y, cache, search.neighbors);
       } else {
         if (!cache.move.swapped) {
           cache.move.route_x = route_x;
@@ -114,11 +161,20 @@ std::vector<Node> SdSwapOneOne::operator()(const Problem &problem,
     }
   }
 
-  // Apply the best move if it improves the solution
-  if (best_delta.value < 0) {
-    DoSdSwapOneOne(best_move, solution, context);
-    return {best_move.route_x, best_move.route_y};
+  // The best move is applied by the caller if it improves the solution
+  if (best_delta.value >= 0) {
+    return {};
   }
-  // Return empty vector if no improvement found
-  return {};
+  caches.best_move = best_move;
+  return {best_delta, [&caches](SpecificSolution &solution, RouteContext &context) {
+            DoSdSwapOneOne(caches.best_move, solution, context);
+            return ModifiedRoutes{caches.best_move.route_x, caches.best_move.route_y};
+          }};
+}
+
+// Creates the cache of the operator
+void SdSwapOneOne::Prepare([[maybe_unused]] const Problem &problem, const SpecificSolution &solution,
+                           const RouteContext &context, CacheMap &cache_map,
+                           [[maybe_unused]] const SearchContext &search) const {
+  cache_map.Get<InterRouteCache<SdSwapOneOneMove>>(solution, context);
 }
\ No newline at end of file
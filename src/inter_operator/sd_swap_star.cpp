@@ -40,15 +40,31 @@
   void SdSwapStarInner(const Problem &problem, const SpecificSolution &solution,
                        [[maybe_unused]] const RouteContext &context, bool swapped, Node route_x,
                        Node route_y, Node node_x, Node node_y, int split_load,
-                       BaseCache<SdSwapStarMove> &cache, StarCaches &star_caches) {
-    auto &&insertion_x = star_caches.Get(route_y, solution.Customer(node_x));
-    auto &&insertion_y = star_caches.Get(route_x, solution.Customer(node_y));
+                       BaseCache<SdSwapStarMove> &cache, StarCaches &star_caches,
+                       const NeighborLists &neighbors) {
+    Node customer_x = solution.Customer(node_x);
+    Node customer_y = solution.Customer(node_y);
     Node predecessor_y = solution.Predecessor(node_y);
     Node successor_y = solution.Successor(node_y);
+    // Node x goes in place of node y or at its best cached insertion, and node y at its best cached
+    // insertion, each only next to a neighbor
+    bool in_place_x = neighbors.IsNeighborInsertion(customer_x, customer_x, solution.Customer(predecessor_y),
+                                                    solution.Customer(successor_y));
+    auto best_insertion_x = star_caches.Get(route_y, customer_x).FindBestIf([&](const Insertion &candidate) {
+      return candidate.predecessor != node_y && candidate.successor != node_y
+             && neighbors.IsNeighborInsertion(customer_x, customer_x, solution.Customer(candidate.predecessor),
+                                              solution.Customer(candidate.successor));
+    });
+    auto best_insertion_y = star_caches.Get(route_x, customer_y).FindBestIf([&](const Insertion &candidate) {
+      return neighbors.IsNeighborInsertion(customer_y, customer_y, solution.Customer(candidate.predecessor),
+                                           solution.Customer(candidate.successor));
+    });
+    if (!(in_place_x || best_insertion_x) || !best_insertion_y) {
+      return;
+    }
     int delta = -CalcDelta(problem, solution, node_y, predecessor_y, successor_y);
-    int delta_x = CalcDelta(problem, solution, node_x, predecessor_y, successor_y);
-    auto best_insertion_y = insertion_y.FindBest();
-    auto best_insertion_x = insertion_x.FindBestWithoutNode(node_y);
+    int delta_x = in_place_x ? CalcDelta(problem, solution, node_x, predecessor_y, successor_y)
+                             : std::numeric_limits<int>::max();
     if (best_insertion_x && best_insertion_x->delta.value < delta_x) {
       delta_x = best_insertion_x->delta.value;
       predecessor_y = best_insertion_x->predecessor;
@@ -72,7 +88,8 @@
   // Overloaded inner function to iterate through nodes in two routes
   void SdSwapStarInner(const Problem &problem, const SpecificSolution &solution,
                        const RouteContext &context, Node route_x, Node route_y,
-                       BaseCache<SdSwapStarMove> &cache, StarCaches &star_caches) {
+                       BaseCache<SdSwapStarMove> &cache, StarCaches &star_caches,
+                       const NeighborLists &neighbors) {
     star_caches.Preprocess(problem, solution, context, route_x);
     star_caches.Preprocess(problem, solution, context, route_y);
     Node node_x = context.Head(route_x);
@@ -83,10 +100,10 @@
         int load_y = solution.Load(node_y);
         if (load_x > load_y) {
           SdSwapStarInner(problem, solution, context, false, route_x, route_y, node_x, node_y,
-                          load_x - load_y, cache, star_caches);
+                          load_x - load_y, cache, star_caches, neighbors);
         } else if (load_y > load_x) {
           SdSwapStarInner(problem, solution, context, true, route_y, route_x, node_y, node_x,
-                          load_y - load_x, cache, star_caches);
+                          load_y - load_x, cache, star_caches, neighbors);
         }
         node_y = solution.Successor(node_y);
       }
@@ -96,19 +113,37 @@
 
   // Main operator function implementing the Split Delivery Swap Star Move
   // This function finds and applies the best route modification
-  std::vector<Node> SdSwapStar::operator()(const Problem &problem,
-                                                           SpecificSolution &solution,
-                                                           RouteContext &context,
-                                                           CacheMap &cache_map) const {
+  InterMove SdSwapStar::Evaluate(const Problem &problem,
+                                                           const SpecificSolution &solution,
+                                                           const RouteContext &context,
+                                                           CacheMap &cache_map,
+                                                           const SearchContext &search) const {
     auto &caches = cache_map.Get<InterRouteCache<SdSwapStarMove>>(solution, context);
     auto &star_caches = cache_map.Get<StarCaches>(solution, context);
+    if (search.pool) {
+      EvaluateInvalidatedPairs(
+          *search.pool, search.stopping, caches, context.NumRoutes(), false,
+          [&](Node route_x, Node route_y) { return context.Overlap(route_x, route_y); },
+          [&](const RoutePairs &pairs) {
+            star_caches.Preprocess(problem, solution, context, pairs, *search.pool, search.stopping);
+          },
+          [&](Node route_x, Node route_y, BaseCache<SdSwapStarMove> &cache) {
+            SdSwapStarInner(problem, solution, context, route_x, route_y, cache, star_caches, search.neighbors);
+          });
+    }
     SdSwapStarMove best_move{};
     Delta<int> best_delta{};
     for (Node route_x = 0; route_x < context.NumRoutes(); ++route_x) {
+      if (search.IsCancelled()) {
+        return {};
+      }
       for (Node route_y = route_x + 1; route_y < context.NumRoutes(); ++route_y) {
         auto &cache = caches.Get(route_x, route_y);
-        if (!cache.TryReuse()) {
-          SdSwapStarInner(problem, solution, context, route_x, route_y, cache, star_caches);
+        if (!caches.TryReuse(cache, !search.pool)) {
+          // Routes in disjoint sectors are not evaluated and keep an empty cache entry
+          if (context.Overlap(route_x, route_y)) {
+            SdSwapStarInner(problem, solution, context, route_x, route_y, cache, star_caches, search.neighbors);
+          }
         } else {
           if (!cache.move.swapped) {
             cache.move.route_x = route_x;
@@ -123,11 +158,22 @@
         }
       }
     }
-    // Apply the best move if it improves the solution
-    if (best_delta.value < 0) {
-      DoSdSwapStar(best_move, solution, context);
-      return {best_move.route_x, best_move.route_y};
+    // The best move is applied by the caller if it improves the solution
+    if (best_delta.value >= 0) {
+      return {};
     }
-    // Return empty vector if no improvement found
-    return {};
+    caches.best_move = best_move;
+    return {best_delta, [&caches](SpecificSolution &solution, RouteContext &context) {
+              DoSdSwapStar(caches.best_move, solution, context);
+              return ModifiedRoutes{caches.best_move.route_x, caches.best_move.route_y};
+            }};
+  }
+
+  // Creates the caches of the operator and prepares the insertion caches of all routes
+  void SdSwapStar::Prepare(const Problem &problem, const SpecificSolution &solution,
+                           const RouteContext &context, CacheMap &cache_map,
+                           const SearchContext &search) const {
+    cache_map.Get<InterRouteCache<SdSwapStarMove>>(solution, context);
+    cache_map.Get<StarCaches>(solution, context).PreprocessAll(problem, solution, context, search.pool,
+                                                                          search.stopping);
   }
\ No newline at end of file
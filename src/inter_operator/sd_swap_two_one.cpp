@@ -95,17 +95,17 @@
     Node predecessor_k = solution.Predecessor(node_k);
     Node successor_k = solution.Successor(node_k);
     int delta_ij
-        = problem.distance_matrix[solution.Customer(predecessor_k)][solution.Customer(node_i)]
-          + problem.distance_matrix[solution.Customer(node_j)][solution.Customer(successor_k)];
+        = problem.distance_matrix(solution.Customer(predecessor_k), solution.Customer(node_i))
+          + problem.distance_matrix(solution.Customer(node_j), solution.Customer(successor_k));
     int delta_ji
-        = problem.distance_matrix[solution.Customer(predecessor_k)][solution.Customer(node_j)]
-          + problem.distance_matrix[solution.Customer(node_i)][solution.Customer(successor_k)];
+        = problem.distance_matrix(solution.Customer(predecessor_k), solution.Customer(node_j))
+          + problem.distance_matrix(solution.Customer(node_i), solution.Customer(successor_k));
     int delta_jk
-        = problem.distance_matrix[solution.Customer(predecessor_ij)][solution.Customer(node_j)]
-          + problem.distance_matrix[solution.Customer(node_k)][solution.Customer(successor_ij)];
+        = problem.distance_matrix(solution.Customer(predecessor_ij), solution.Customer(node_j))
+          + problem.distance_matrix(solution.Customer(node_k), solution.Customer(successor_ij));
     int delta_kj
-        = problem.distance_matrix[solution.Customer(predecessor_ij)][solution.Customer(node_k)]
-          + problem.distance_matrix[solution.Customer(node_j)][solution.Customer(successor_ij)];
+        = problem.distance_matrix(solution.Customer(predecessor_ij), solution.Customer(node_k))
+          + problem.distance_matrix(solution.Customer(node_j), solution.Customer(successor_ij));
     bool direction_ij = true;
     if (delta_ij > delta_ji) {
       delta_ij = delta_ji;
@@ -117,7 +117,7 @@
       direction_jk = false;
     }
     int delta = base_delta
-                + problem.distance_matrix[solution.Customer(node_j)][solution.Customer(node_k)]
+                + problem.distance_matrix(solution.Customer(node_j), solution.Customer(node_k))
                 + delta_ij + delta_jk;
     if (cache.delta.Update(delta)) {
       cache.move = {0,      route_ij, route_k,    predecessor_ij, successor_ij, node_i,
@@ -134,8 +134,8 @@
     Node predecessor_k = solution.Predecessor(node_k);
     Node successor_k = solution.Successor(node_k);
     base_delta
-        += problem.distance_matrix[solution.Customer(predecessor_ij)][solution.Customer(node_k)]
-           + problem.distance_matrix[solution.Customer(node_k)][solution.Customer(successor_ij)];
+        += problem.distance_matrix(solution.Customer(predecessor_ij), solution.Customer(node_k))
+           + problem.distance_matrix(solution.Customer(node_k), solution.Customer(successor_ij));
     for (bool direction_ij : {true, false}) {
       int before_ij = node_i;
       int after_ij = node_j;
@@ -146,17 +146,14 @@
         int delta_ijk;
         if (direction_ijk) {
           delta_ijk
-              = problem
-                    .distance_matrix[solution.Customer(predecessor_k)][solution.Customer(before_ij)]
-                + problem.distance_matrix[solution.Customer(after_ij)][solution.Customer(node_k)]
-                + problem
-                      .distance_matrix[solution.Customer(node_k)][solution.Customer(successor_k)];
+              = problem.distance_matrix(solution.Customer(predecessor_k), solution.Customer(before_ij))
+                + problem.distance_matrix(solution.Customer(after_ij), solution.Customer(node_k))
+                + problem.distance_matrix(solution.Customer(node_k), solution.Customer(successor_k));
         } else {
           delta_ijk
-              = problem.distance_matrix[solution.Customer(predecessor_k)][solution.Customer(node_k)]
-                + problem.distance_matrix[solution.Customer(node_k)][solution.Customer(before_ij)]
-                + problem
-                      .distance_matrix[solution.Customer(after_ij)][solution.Customer(successor_k)];
+              = problem.distance_matrix(solution.Customer(predecessor_k), solution.Customer(node_k))
+                + problem.distance_matrix(solution.Customer(node_k), solution.Customer(before_ij))
+                + problem.distance_matrix(solution.Customer(after_ij), solution.Customer(successor_k));
         }
         int delta = base_delta + delta_ijk;
         if (cache.delta.Update(delta)) {
@@ -170,23 +167,60 @@
   // Core search method to explore Swap Two-One moves between routes
   void SdSwapTwoOneInner(const Problem &problem, const SpecificSolution &solution,
                          const RouteContext &context, Node route_ij, Node route_k,
-                         BaseCache<SdSwapTwoOneMove> &cache) {
+                         BaseCache<SdSwapTwoOneMove> &cache, const NeighborLists &neighbors) {
+    static thread_local CandidateNodes nodes_k; // Nodes of route k paired with a pair of route ij
+    int length_k = context.Length(route_k);
     Node node_i = context.Head(route_ij);
     Node node_j = solution.Successor(node_i);
     while (node_j) {
       int load_i = solution.Load(node_i);
       int load_j = solution.Load(node_j);
-      for (Node node_k = context.Head(route_k); node_k; node_k = solution.Successor(node_k)) {
+      Node predecessor_ij = solution.Predecessor(node_i);
+      Node successor_ij = solution.Successor(node_j);
+      Node customer_i = solution.Customer(node_i);
+      Node customer_j = solution.Customer(node_j);
+      // A pair next to the depot connects k to it, so every node of k is in the neighborhood
+      if (!predecessor_ij || !successor_ij
+          || !EnumerateNeighborVisits(neighbors, length_k,
+                                      {customer_i, customer_j, solution.Customer(predecessor_ij),
+                                       solution.Customer(successor_ij)})) {
+        nodes_k.Scan(context.Head(route_k));
+      } else {
+        // Nodes of k at the ends of the route, next to or neighbors of the pair, or neighbors of
+        // the nodes around the pair
+        nodes_k.Collect(solution.MaxNodeIndex());
+        nodes_k.Add(context.Head(route_k));
+        nodes_k.Add(context.Tail(route_k));
+        for (Node customer : {customer_i, customer_j}) {
+          ForEachNeighborVisit(solution, context, neighbors, customer, route_k, [&](Node node_index) {
+            nodes_k.Add(node_index);
+            nodes_k.Add(solution.Predecessor(node_index));
+            nodes_k.Add(solution.Successor(node_index));
+          });
+        }
+        for (Node customer : {solution.Customer(predecessor_ij), solution.Customer(successor_ij)}) {
+          ForEachNeighborVisit(solution, context, neighbors, customer, route_k,
+                               [&](Node node_index) { nodes_k.Add(node_index); });
+        }
+      }
+      for (Node node_k = nodes_k.First(); node_k; node_k = nodes_k.Next(solution, node_k)) {
         int load_k = solution.Load(node_k);
-        Node predecessor_ij = solution.Predecessor(node_i);
-        Node successor_ij = solution.Successor(node_j);
+        // The pair i, j takes the place of k, k takes the place of the pair, and the split visit
+        // ends up next to k or to the pair
+        Node customer_k = solution.Customer(node_k);
+        if (!neighbors.IsNeighborInsertion(customer_i, customer_j,
+                                           solution.Customer(solution.Predecessor(node_k)),
+                                           solution.Customer(solution.Successor(node_k)))
+            && !neighbors.IsNeighborInsertion(customer_k, customer_k, solution.Customer(predecessor_ij),
+                                              solution.Customer(successor_ij))
+            && !neighbors.IsNeighborInsertion(customer_i, customer_j, customer_k, customer_k)) {
+          continue;
+        }
         int base_delta
-            = -problem.distance_matrix[solution.Customer(predecessor_ij)][solution.Customer(node_i)]
-              - problem.distance_matrix[solution.Customer(node_j)][solution.Customer(successor_ij)]
-              - problem.distance_matrix[solution.Customer(solution.Predecessor(node_k))]
-                                       [solution.Customer(node_k)]
-              - problem.distance_matrix[solution.Customer(node_k)]
-                                       [solution.Customer(solution.Successor(node_k))];
+            = -problem.distance_matrix(solution.Customer(predecessor_ij), solution.Customer(node_i))
+              - problem.distance_matrix(solution.Customer(node_j), solution.Customer(successor_ij))
+              - problem.distance_matrix(solution.Customer(solution.Predecessor(node_k)), solution.Customer(node_k))
+              - problem.distance_matrix(solution.Customer(node_k), solution.Customer(solution.Successor(node_k)));
         if (load_i + load_j > load_k) {
           if (load_i < load_k) {
             SdSwapTwoOne0(problem, solution, context, route_ij, route_k, node_i, node_j, node_k,
@@ -207,21 +241,32 @@
   }
 
   // Main operator to find and apply the best Swap Two-One move
-  std::vector<Node> SdSwapTwoOne::operator()(const Problem &problem,
-                                                             SpecificSolution &solution,
-                                                             RouteContext &context,
-                                                             CacheMap &cache_map) const {
+  InterMove SdSwapTwoOne::Evaluate(const Problem &problem,
+                                                             const SpecificSolution &solution,
+                                                             const RouteContext &context,
+                                                             CacheMap &cache_map,
+                                                             const SearchContext &search) const {
     auto &caches = cache_map.Get<InterRouteCache<SdSwapTwoOneMove>>(solution, context);
+    if (search.pool) {
+      EvaluateInvalidatedPairs(*search.pool, search.stopping, caches, context.NumRoutes(), true,
+                               [&](Node route_ij, Node route_k, BaseCache<SdSwapTwoOneMove> &cache) {
+                                 SdSwapTwoOneInner(problem, solution, context, route_ij, route_k, cache,
+                                                   search.neighbors);
+                               });
+    }
     SdSwapTwoOneMove best_move{};
     Delta<int> best_delta{};
     for (Node route_ij = 0; route_ij < context.NumRoutes(); ++route_ij) {
+      if (search.IsCancelled()) {
+        return {};
+      }
       for (Node route_k = 0; route_k < context.NumRoutes(); ++route_k) {
         if (route_ij == route_k) {
           continue;
         }
         auto &cache = caches.Get(route_ij, route_k);
-        if (!cache.TryReuse()) {
-          SdSwapTwoOneInner(problem, solution, context, route_ij, route_k, cache);
+        if (!caches.TryReuse(cache, !search.pool)) {
+          SdSwapTwoOneInner(problem, solution, context, route_ij, route_k, cache, search.neighbors);
         } else {
           cache.move.route_ij = route_ij;
           cache.move.route_k = route_k;
@@ -231,10 +276,20 @@
         }
       }
     }
-    // Apply the best move if it improves the solution
-    if (best_delta.value < 0) {
-      DoSdSwapTwoOne(best_move, solution, context);
-      return {best_move.route_ij, best_move.route_k};
+    // The best move is applied by the caller if it improves the solution
+    if (best_delta.value >= 0) {
+      return {};
     }
-    return {};// Return empty vector if no improvement found
+    caches.best_move = best_move;
+    return {best_delta, [&caches](SpecificSolution &solution, RouteContext &context) {
+              DoSdSwapTwoOne(caches.best_move, solution, context);
+              return ModifiedRoutes{caches.best_move.route_ij, caches.best_move.route_k};
+            }};
+  }
+
+  // Creates the cache of the operator
+  void SdSwapTwoOne::Prepare([[maybe_unused]] const Problem &problem, const SpecificSolution &solution,
+                             const RouteContext &context, CacheMap &cache_map,
+                             [[maybe_unused]] const SearchContext &search) const {
+    cache_map.Get<InterRouteCache<SdSwapTwoOneMove>>(solution, context);
   }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "../../include/inter_operator.h"
 
 #include "../../include/base_cache.h"
+#include "../../include/epoch_table.h"
 
   // Struct to represent a swap move operation between routes
   template <int, int> struct SwapMove {
@@ -51,18 +52,22 @@
   template <int num_x, int num_y>
   void UpdateShift(const Problem &problem, const SpecificSolution &solution, Node route_x, Node route_y,
                    Node left, Node right, Node predecessor, Node successor, Node base_x,
-                   BaseCache<SwapMove<num_x, num_y>> &cache) {
+                   BaseCache<SwapMove<num_x, num_y>> &cache, const NeighborLists &neighbors) {
     Node customer_left = solution.Customer(left);
     Node customer_predecessor = solution.Customer(predecessor);
     Node customer_right = solution.Customer(right);
     Node customer_successor = solution.Customer(successor);
-    int d1 = problem.distance_matrix[customer_left][customer_predecessor]
-             + problem.distance_matrix[customer_right][customer_successor];
-    int d2 = problem.distance_matrix[customer_left][customer_successor]
-             + problem.distance_matrix[customer_right][customer_predecessor];
+    if (!neighbors.IsNeighborInsertion(customer_left, customer_right, customer_predecessor,
+                                       customer_successor)) {
+      return;
+    }
+    int d1 = problem.distance_matrix(customer_left, customer_predecessor)
+             + problem.distance_matrix(customer_right, customer_successor);
+    int d2 = problem.distance_matrix(customer_left, customer_successor)
+             + problem.distance_matrix(customer_right, customer_predecessor);
     int direction = d1 >= d2;
     int delta = base_x + (direction ? d2 : d1)
-                - problem.distance_matrix[customer_predecessor][customer_successor];
+                - problem.distance_matrix(customer_predecessor, customer_successor);
     if (cache.delta.Update(delta)) {
       cache.move = {route_x, route_y, direction, -1, left, predecessor, right, successor};
     }
@@ -72,7 +77,7 @@
   template <int num_x, int num_y>
   void UpdateSwap(const Problem &problem, const SpecificSolution &solution, Node route_x, Node route_y,
                   Node left_x, Node right_x, Node left_y, Node right_y, int base_x,
-                  BaseCache<SwapMove<num_x, num_y>> &cache) {
+                  BaseCache<SwapMove<num_x, num_y>> &cache, const NeighborLists &neighbors) {
     Node customer_left_x = solution.Customer(left_x);
     Node customer_right_x = solution.Customer(right_x);
     Node customer_left_y = solution.Customer(left_y);
@@ -81,28 +86,114 @@
     Node successor_x = solution.Customer(solution.Successor(right_x));
     Node predecessor_y = solution.Customer(solution.Predecessor(left_y));
     Node successor_y = solution.Customer(solution.Successor(right_y));
-    int d1 = problem.distance_matrix[customer_left_x][predecessor_y]
-             + problem.distance_matrix[customer_right_x][successor_y];
-    int d2 = problem.distance_matrix[customer_left_x][successor_y]
-             + problem.distance_matrix[customer_right_x][predecessor_y];
-    int d3 = problem.distance_matrix[customer_left_y][predecessor_x]
-             + problem.distance_matrix[customer_right_y][successor_x];
-    int d4 = problem.distance_matrix[customer_left_y][successor_x]
-             + problem.distance_matrix[customer_right_y][predecessor_x];
+    if (!neighbors.IsNeighborInsertion(customer_left_x, customer_right_x, predecessor_y, successor_y)
+        && !neighbors.IsNeighborInsertion(customer_left_y, customer_right_y, predecessor_x,
+                                          successor_x)) {
+      return;
+    }
+    int d1 = problem.distance_matrix(customer_left_x, predecessor_y)
+             + problem.distance_matrix(customer_right_x, successor_y);
+    int d2 = problem.distance_matrix(customer_left_x, successor_y)
+             + problem.distance_matrix(customer_right_x, predecessor_y);
+    int d3 = problem.distance_matrix(customer_left_y, predecessor_x)
+             + problem.distance_matrix(customer_right_y, successor_x);
+    int d4 = problem.distance_matrix(customer_left_y, successor_x)
+             + problem.distance_matrix(customer_right_y, predecessor_x);
     int direction_x = d1 >= d2;
     int direction_y = d3 >= d4;
     int delta = base_x + (direction_x ? d2 : d1) + (direction_y ? d4 : d3)
-                - problem.distance_matrix[customer_left_y][predecessor_y]
-                - problem.distance_matrix[customer_right_y][successor_y];
+                - problem.distance_matrix(customer_left_y, predecessor_y)
+                - problem.distance_matrix(customer_right_y, successor_y);
     if (cache.delta.Update(delta)) {
       cache.move = {route_x, route_y, direction_x, direction_y, left_x, left_y, right_x, right_y};
     }
   }
 
+  // Node a number of steps before a node in its route, zero past the head
+  Node StepBack(const SpecificSolution &solution, Node node_index, int steps) {
+    for (int i = 0; node_index && i < steps; ++i) {
+      node_index = solution.Predecessor(node_index);
+    }
+    return node_index;
+  }
+
+  // Evaluates the shifts of a segment of route x to the positions of route y next to a neighbor
+  // of its ends or to the depot
+  template <int num_x, int num_y>
+  void GranularShift(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                     Node route_x, Node route_y, Node left_x, Node right_x, int base_x,
+                     BaseCache<SwapMove<num_x, num_y>> &cache, const NeighborLists &neighbors) {
+    static thread_local EpochTable<bool> evaluated; // Predecessors of the positions evaluated
+    evaluated.Reset(solution.MaxNodeIndex() + 1);
+    auto evaluate = [&](Node predecessor) {
+      if (evaluated.Insert(predecessor)) {
+        Node successor = predecessor ? solution.Successor(predecessor) : context.Head(route_y);
+        UpdateShift(problem, solution, route_x, route_y, left_x, right_x, predecessor, successor, base_x,
+                    cache, neighbors);
+      }
+    };
+    evaluate(0);
+    evaluate(context.Tail(route_y));
+    for (Node customer : {solution.Customer(left_x), solution.Customer(right_x)}) {
+      ForEachNeighborVisit(solution, context, neighbors, customer, route_y, [&](Node node_index) {
+        evaluate(node_index);
+        evaluate(solution.Predecessor(node_index));
+      });
+    }
+  }
+
+  // Evaluates the swaps of a segment of route x, away from the depot, with the segments of route y
+  // that form an edge between neighbors or with the depot
+  template <int num_x, int num_y>
+  void GranularSwap(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                    Node route_x, Node route_y, Node left_x, Node right_x, int base_x, int load_y_lower,
+                    int load_y_upper, BaseCache<SwapMove<num_x, num_y>> &cache, const NeighborLists &neighbors) {
+    static thread_local EpochTable<bool> evaluated; // First nodes of the segments evaluated
+    evaluated.Reset(solution.MaxNodeIndex() + 1);
+    auto evaluate = [&](Node left_y) {
+      if (!left_y || !evaluated.Insert(left_y)) {
+        return;
+      }
+      int load_y = solution.Load(left_y);
+      Node right_y = left_y;
+      for (int i = 1; i < num_y; ++i) {
+        right_y = solution.Successor(right_y);
+        if (!right_y) {
+          return;
+        }
+        load_y += solution.Load(right_y);
+      }
+      if (load_y >= load_y_lower && load_y <= load_y_upper) {
+        UpdateSwap(problem, solution, route_x, route_y, left_x, right_x, left_y, right_y, base_x, cache,
+                   neighbors);
+      }
+    };
+    evaluate(context.Head(route_y));
+    evaluate(StepBack(solution, context.Tail(route_y), num_y - 1));
+    // The segment of x goes next to a neighbor of its ends
+    for (Node customer : {solution.Customer(left_x), solution.Customer(right_x)}) {
+      ForEachNeighborVisit(solution, context, neighbors, customer, route_y, [&](Node node_index) {
+        evaluate(solution.Successor(node_index));
+        evaluate(StepBack(solution, node_index, num_y));
+      });
+    }
+    // The segment of y has an end next to a neighbor of the nodes around the segment of x
+    Node predecessor_x = solution.Predecessor(left_x);
+    Node successor_x = solution.Successor(right_x);
+    for (Node customer : {solution.Customer(predecessor_x), solution.Customer(successor_x)}) {
+      ForEachNeighborVisit(solution, context, neighbors, customer, route_y, [&](Node node_index) {
+        evaluate(node_index);
+        evaluate(StepBack(solution, node_index, num_y - 1));
+      });
+    }
+  }
+
   // Core function to explore swap moves within and between routes
   template <int num_x, int num_y>
-  void SwapInner(const Problem &problem, SpecificSolution &solution, RouteContext &context, Node route_x,
-                 Node route_y, BaseCache<SwapMove<num_x, num_y>> &cache) {
+  void SwapInner(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+                 Node route_x, Node route_y, BaseCache<SwapMove<num_x, num_y>> &cache,
+                 const NeighborLists &neighbors) {
+    int length_y = context.Length(route_y);
     Node left_x = context.Head(route_x);
     int load_x = solution.Load(left_x);
     Node right_x = left_x;
@@ -111,22 +202,24 @@
       load_x += solution.Load(right_x);
     }
     while (right_x) {
-      int base_x = -problem.distance_matrix[solution.Customer(left_x)]
-                                           [solution.Customer(solution.Predecessor(left_x))]
-                   - problem.distance_matrix[solution.Customer(right_x)]
-                                            [solution.Customer(solution.Successor(right_x))];
+      int base_x = -problem.distance_matrix(solution.Customer(left_x), solution.Customer(solution.Predecessor(left_x)))
+                   - problem.distance_matrix(solution.Customer(right_x), solution.Customer(solution.Successor(right_x)));
       if (num_y == 0) {
-        base_x += problem.distance_matrix[solution.Customer(solution.Predecessor(left_x))]
-                                         [solution.Customer(solution.Successor(right_x))];
+        base_x += problem.distance_matrix(solution.Customer(solution.Predecessor(left_x)), solution.Customer(solution.Successor(right_x)));
       }
       int load_y_lower = -problem.capacity + context.Load(route_y) + load_x;
       if (num_y == 0) {
-        if (load_y_lower <= 0) {
+        if (load_y_lower <= 0
+            && EnumerateNeighborVisits(neighbors, length_y,
+                                       {solution.Customer(left_x), solution.Customer(right_x)})) {
+          GranularShift(problem, solution, context, route_x, route_y, left_x, right_x, base_x, cache,
+                        neighbors);
+        } else if (load_y_lower <= 0) {
           Node predecessor = 0;
           Node successor = context.Head(route_y);
           while (true) {
             UpdateShift(problem, solution, route_x, route_y, left_x, right_x, predecessor,
-                        successor, base_x, cache);
+                        successor, base_x, cache, neighbors);
             if (!successor) {
               break;
             }
@@ -136,22 +229,33 @@
         }
       } else {
         int load_y_upper = problem.capacity - context.Load(route_x) + load_x;
-        Node left_y = context.Head(route_y);
-        int load_y = solution.Load(left_y);
-        Node right_y = left_y;
-        for (int i = 1; right_y && i < num_y; ++i) {
-          right_y = solution.Successor(right_y);
-          load_y += solution.Load(right_y);
-        }
-        while (right_y) {
-          if (load_y >= load_y_lower && load_y <= load_y_upper) {
-            UpdateSwap(problem, solution, route_x, route_y, left_x, right_x, left_y, right_y,
-                       base_x, cache);
+        Node predecessor_x = solution.Predecessor(left_x);
+        Node successor_x = solution.Successor(right_x);
+        // Segments of y moved next to the depot are always in the neighborhood, so they are scanned
+        if (predecessor_x && successor_x
+            && EnumerateNeighborVisits(neighbors, length_y,
+                                       {solution.Customer(left_x), solution.Customer(right_x),
+                                        solution.Customer(predecessor_x), solution.Customer(successor_x)})) {
+          GranularSwap(problem, solution, context, route_x, route_y, left_x, right_x, base_x, load_y_lower,
+                       load_y_upper, cache, neighbors);
+        } else {
+          Node left_y = context.Head(route_y);
+          int load_y = solution.Load(left_y);
+          Node right_y = left_y;
+          for (int i = 1; right_y && i < num_y; ++i) {
+            right_y = solution.Successor(right_y);
+            load_y += solution.Load(right_y);
+          }
+          while (right_y) {
+            if (load_y >= load_y_lower && load_y <= load_y_upper) {
+              UpdateSwap(problem, solution, route_x, route_y, left_x, right_x, left_y, right_y,
+                         base_x, cache, neighbors);
+            }
+            load_y -= solution.Load(left_y);
+            left_y = solution.Successor(left_y);
+            right_y = solution.Successor(right_y);
+            load_y += solution.Load(right_y);
           }
-          load_y -= solution.Load(left_y);
-          left_y = solution.Successor(left_y);
-          right_y = solution.Successor(right_y);
-          load_y += solution.Load(right_y);
         }
       }
       load_x -= solution.Load(left_x);
@@ -162,21 +266,33 @@
   }
 
   // Operator overload to perform swap moves between routes
-  template <int num_x, int num_y> std::vector<Node> Swap<num_x, num_y>::operator()(
-      const Problem &problem, SpecificSolution &solution, RouteContext &context,
-      CacheMap &cache_map) const {
+  template <int num_x, int num_y> InterMove Swap<num_x, num_y>::Evaluate(
+      const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+      CacheMap &cache_map, const SearchContext &search) const {
     auto &caches = cache_map.Get<InterRouteCache<SwapMove<num_x, num_y>>>(solution, context);
+    if (search.pool) {
+      EvaluateInvalidatedPairs(
+          *search.pool, search.stopping, caches, context.NumRoutes(), num_x != num_y,
+          [&](Node route_x, Node route_y, BaseCache<SwapMove<num_x, num_y>> &cache) {
+            SwapInner<num_x, num_y>(problem, solution, context, route_x, route_y, cache,
+                                    search.neighbors);
+          });
+    }
     SwapMove<num_x, num_y> best_move{};
     Delta<int> best_delta{};
     for (Node route_x = 0; route_x < context.NumRoutes(); ++route_x) {
+      if (search.IsCancelled()) {
+        return {};
+      }
       for (Node route_y = num_x != num_y ? 0 : route_x + 1; route_y < context.NumRoutes();
            ++route_y) {
         if (num_x != num_y && route_x == route_y) {
           continue;
         }
         auto &cache = caches.Get(route_x, route_y);
-        if (!cache.TryReuse()) {
-          SwapInner<num_x, num_y>(problem, solution, context, route_x, route_y, cache);
+        if (!caches.TryReuse(cache, !search.pool)) {
+          SwapInner<num_x, num_y>(problem, solution, context, route_x, route_y, cache,
+                                    search.neighbors);
         } else {
           cache.move.route_x = route_x;
           cache.move.route_y = route_y;
@@ -186,11 +302,22 @@
         }
       }
     }
-    if (best_delta.value < 0) {
-      DoSwap(best_move, solution, context);
-      return {best_move.route_x, best_move.route_y};
+    // The best move is applied by the caller if it improves the solution
+    if (best_delta.value >= 0) {
+      return {};
     }
-    return {};
+    caches.best_move = best_move;
+    return {best_delta, [&caches](SpecificSolution &solution, RouteContext &context) {
+              DoSwap(caches.best_move, solution, context);
+              return ModifiedRoutes{caches.best_move.route_x, caches.best_move.route_y};
+            }};
+  }
+
+  // Creates the cache of the operator
+  template <int num_x, int num_y> void Swap<num_x, num_y>::Prepare(
+      [[maybe_unused]] const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
+      CacheMap &cache_map, [[maybe_unused]] const SearchContext &search) const {
+    cache_map.Get<InterRouteCache<SwapMove<num_x, num_y>>>(solution, context);
   }
 
   // Explicit template instantiations for different segment swap configurations
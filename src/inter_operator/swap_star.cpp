@@ -36,12 +36,13 @@
   // Core function to explore SwapStar moves between routes
   void SwapStarInner(const Problem &problem, const SpecificSolution &solution, const RouteContext &context,
                      Node route_x, Node route_y, BaseCache<SwapStarMove> &cache,
-                     StarCaches &star_caches) {
+                     StarCaches &star_caches, const NeighborLists &neighbors) {
     star_caches.Preprocess(problem, solution, context, route_x);
     star_caches.Preprocess(problem, solution, context, route_y);
     Node node_x = context.Head(route_x);
     while (node_x) {
-      auto &&insertion_x = star_caches.Get(route_y, solution.Customer(node_x));
+      Node customer_x = solution.Customer(node_x);
+      auto &&insertion_x = star_caches.Get(route_y, customer_x);
       int load_x = solution.Load(node_x);
       int load_y_lower = -problem.capacity + context.Load(route_y) + load_x;
       int load_y_upper = problem.capacity - context.Load(route_x) + load_x;
@@ -49,31 +50,49 @@
       while (node_y) {
         int load_y = solution.Load(node_y);
         if (load_y >= load_y_lower && load_y <= load_y_upper) {
-          auto &&insertion_y = star_caches.Get(route_x, solution.Customer(node_y));
+          Node customer_y = solution.Customer(node_y);
           Node predecessor_x = solution.Predecessor(node_x);
           Node successor_x = solution.Successor(node_x);
           Node predecessor_y = solution.Predecessor(node_y);
           Node successor_y = solution.Successor(node_y);
-          int delta = -CalcDelta(problem, solution, node_x, predecessor_x, successor_x)
-                      - CalcDelta(problem, solution, node_y, predecessor_y, successor_y);
-          int delta_x = CalcDelta(problem, solution, node_x, predecessor_y, successor_y);
-          int delta_y = CalcDelta(problem, solution, node_y, predecessor_x, successor_x);
-          auto best_insertion_x = insertion_x.FindBestWithoutNode(node_y);
-          if (best_insertion_x && best_insertion_x->delta.value < delta_x) {
-            delta_x = best_insertion_x->delta.value;
-            predecessor_y = best_insertion_x->predecessor;
-            successor_y = best_insertion_x->successor;
-          }
-          auto best_insertion_y = insertion_y.FindBestWithoutNode(node_x);
-          if (best_insertion_y && best_insertion_y->delta.value < delta_y) {
-            delta_y = best_insertion_y->delta.value;
-            predecessor_x = best_insertion_y->predecessor;
-            successor_x = best_insertion_y->successor;
-          }
-          delta += delta_x + delta_y;
-          if (cache.delta.Update(delta)) {
-            cache.move = {route_x,     route_y, node_x,        predecessor_y,
-                          successor_y, node_y,  predecessor_x, successor_x};
+          // Each node goes in place of the other or at the best cached insertion, whichever of
+          // them are next to a neighbor
+          bool in_place_x = neighbors.IsNeighborInsertion(customer_x, customer_x, solution.Customer(predecessor_y),
+                                                          solution.Customer(successor_y));
+          bool in_place_y = neighbors.IsNeighborInsertion(customer_y, customer_y, solution.Customer(predecessor_x),
+                                                          solution.Customer(successor_x));
+          auto best_insertion_x = insertion_x.FindBestIf([&](const Insertion &candidate) {
+            return candidate.predecessor != node_y && candidate.successor != node_y
+                   && neighbors.IsNeighborInsertion(customer_x, customer_x, solution.Customer(candidate.predecessor),
+                                                    solution.Customer(candidate.successor));
+          });
+          auto best_insertion_y = star_caches.Get(route_x, customer_y).FindBestIf([&](const Insertion &candidate) {
+            return candidate.predecessor != node_x && candidate.successor != node_x
+                   && neighbors.IsNeighborInsertion(customer_y, customer_y, solution.Customer(candidate.predecessor),
+                                                    solution.Customer(candidate.successor));
+          });
+          if ((in_place_x || best_insertion_x) && (in_place_y || best_insertion_y)) {
+            int delta = -CalcDelta(problem, solution, node_x, predecessor_x, successor_x)
+                        - CalcDelta(problem, solution, node_y, predecessor_y, successor_y);
+            int delta_x = in_place_x ? CalcDelta(problem, solution, node_x, predecessor_y, successor_y)
+                                     : std::numeric_limits<int>::max();
+            int delta_y = in_place_y ? CalcDelta(problem, solution, node_y, predecessor_x, successor_x)
+                                     : std::numeric_limits<int>::max();
+            if (best_insertion_x && best_insertion_x->delta.value < delta_x) {
+              delta_x = best_insertion_x->delta.value;
+              predecessor_y = best_insertion_x->predecessor;
+              successor_y = best_insertion_x->successor;
+            }
+            if (best_insertion_y && best_insertion_y->delta.value < delta_y) {
+              delta_y = best_insertion_y->delta.value;
+              predecessor_x = best_insertion_y->predecessor;
+              successor_x = best_insertion_y->successor;
+            }
+            delta += delta_x + delta_y;
+            if (cache.delta.Update(delta)) {
+              cache.move = {route_x,     route_y, node_x,        predecessor_y,
+                            successor_y, node_y,  predecessor_x, successor_x};
+            }
           }
         }
         node_y = solution.Successor(node_y);
@@ -83,18 +102,36 @@
   }
 
   // Operator to perform SwapStar moves across routes
-  std::vector<Node> SwapStar::operator()(const Problem &problem, SpecificSolution &solution,
-                                                         RouteContext &context,
-                                                         CacheMap &cache_map) const {
+  InterMove SwapStar::Evaluate(const Problem &problem, const SpecificSolution &solution,
+                                                         const RouteContext &context,
+                                                         CacheMap &cache_map,
+                                                         const SearchContext &search) const {
     auto &caches = cache_map.Get<InterRouteCache<SwapStarMove>>(solution, context);
     auto &star_caches = cache_map.Get<StarCaches>(solution, context);
+    if (search.pool) {
+      EvaluateInvalidatedPairs(
+          *search.pool, search.stopping, caches, context.NumRoutes(), false,
+          [&](Node route_x, Node route_y) { return context.Overlap(route_x, route_y); },
+          [&](const RoutePairs &pairs) {
+            star_caches.Preprocess(problem, solution, context, pairs, *search.pool, search.stopping);
+          },
+          [&](Node route_x, Node route_y, BaseCache<SwapStarMove> &cache) {
+            SwapStarInner(problem, solution, context, route_x, route_y, cache, star_caches, search.neighbors);
+          });
+    }
     SwapStarMove best_move{};
     Delta<int> best_delta{};
     for (Node route_x = 0; route_x < context.NumRoutes(); ++route_x) {
+      if (search.IsCancelled()) {
+        return {};
+      }
       for (Node route_y = route_x + 1; route_y < context.NumRoutes(); ++route_y) {
         auto &cache = caches.Get(route_x, route_y);
-        if (!cache.TryReuse()) {
-          SwapStarInner(problem, solution, context, route_x, route_y, cache, star_caches);
+        if (!caches.TryReuse(cache, !search.pool)) {
+          // Routes in disjoint sectors are not evaluated and keep an empty cache entry
+          if (context.Overlap(route_x, route_y)) {
+            SwapStarInner(problem, solution, context, route_x, route_y, cache, star_caches, search.neighbors);
+          }
         } else {
           cache.move.route_x = route_x;
           cache.move.route_y = route_y;
@@ -104,10 +141,22 @@
         }
       }
     }
-    // Apply best move if it improves the solution
-    if (best_delta.value < 0) {
-      DoSwapStar(best_move, solution, context);
-      return {best_move.route_x, best_move.route_y};
+    // The best move is applied by the caller if it improves the solution
+    if (best_delta.value >= 0) {
+      return {};
     }
-    return {};
+    caches.best_move = best_move;
+    return {best_delta, [&caches](SpecificSolution &solution, RouteContext &context) {
+              DoSwapStar(caches.best_move, solution, context);
+              return ModifiedRoutes{caches.best_move.route_x, caches.best_move.route_y};
+            }};
+  }
+
+  // Creates the caches of the operator and prepares the insertion caches of all routes
+  void SwapStar::Prepare(const Problem &problem, const SpecificSolution &solution,
+                         const RouteContext &context, CacheMap &cache_map,
+                         const SearchContext &search) const {
+    cache_map.Get<InterRouteCache<SwapStarMove>>(solution, context);
+    cache_map.Get<StarCaches>(solution, context).PreprocessAll(problem, solution, context, search.pool,
+                                                                          search.stopping);
   }
\ No newline at end of file
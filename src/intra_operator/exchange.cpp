@@ -53,14 +53,14 @@ void ExchangeInner(const Problem &problem, const SpecificSolution &solution, Nod
   // Compares route distances before and after potential exchange
 
   int delta
-      = problem.distance_matrix[solution.Customer(predecessor_a)][solution.Customer(node_b)]
-        + problem.distance_matrix[solution.Customer(node_b)][solution.Customer(successor_a)]
-        + problem.distance_matrix[solution.Customer(predecessor_b)][solution.Customer(node_a)]
-        + problem.distance_matrix[solution.Customer(node_a)][solution.Customer(successor_b)]
-        - problem.distance_matrix[solution.Customer(predecessor_a)][solution.Customer(node_a)]
-        - problem.distance_matrix[solution.Customer(node_a)][solution.Customer(successor_a)]
-        - problem.distance_matrix[solution.Customer(predecessor_b)][solution.Customer(node_b)]
-        - problem.distance_matrix[solution.Customer(node_b)][solution.Customer(successor_b)];
+      = problem.distance_matrix(solution.Customer(predecessor_a), solution.Customer(node_b))
+        + problem.distance_matrix(solution.Customer(node_b), solution.Customer(successor_a))
+        + problem.distance_matrix(solution.Customer(predecessor_b), solution.Customer(node_a))
+        + problem.distance_matrix(solution.Customer(node_a), solution.Customer(successor_b))
+        - problem.distance_matrix(solution.Customer(predecessor_a), solution.Customer(node_a))
+        - problem.distance_matrix(solution.Customer(node_a), solution.Customer(successor_a))
+        - problem.distance_matrix(solution.Customer(predecessor_b), solution.Customer(node_b))
+        - problem.distance_matrix(solution.Customer(node_b), solution.Customer(successor_b));
 
   // Update best move if current exchange provides a cost improvement
   if (best_delta.Update(delta)) {
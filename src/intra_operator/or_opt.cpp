@@ -57,24 +57,23 @@ template <int num> void OrOptInner(const Problem &problem, const SpecificSolutio
 
   // Calculate base delta by removing the segment
   int delta
-      = problem.distance_matrix[solution.Customer(predecessor_head)]
-                                [solution.Customer(successor_tail)]
-        - problem.distance_matrix[solution.Customer(predecessor_head)][solution.Customer(head)]
-        - problem.distance_matrix[solution.Customer(tail)][solution.Customer(successor_tail)]
-        - problem.distance_matrix[solution.Customer(predecessor)][solution.Customer(successor)];
+      = problem.distance_matrix(solution.Customer(predecessor_head), solution.Customer(successor_tail))
+        - problem.distance_matrix(solution.Customer(predecessor_head), solution.Customer(head))
+        - problem.distance_matrix(solution.Customer(tail), solution.Customer(successor_tail))
+        - problem.distance_matrix(solution.Customer(predecessor), solution.Customer(successor));
   
   bool reversed = false; // Flag to track if segment needs to be reversed
   
   // Calculate delta for normal insertion
   int insertion_delta
-      = problem.distance_matrix[solution.Customer(predecessor)][solution.Customer(head)]
-        + problem.distance_matrix[solution.Customer(successor)][solution.Customer(tail)];
+      = problem.distance_matrix(solution.Customer(predecessor), solution.Customer(head))
+        + problem.distance_matrix(solution.Customer(successor), solution.Customer(tail));
 
   // For moves involving more than one node, check reversed insertion
   if (num > 1) {
     int reversed_delta
-        = problem.distance_matrix[solution.Customer(predecessor)][solution.Customer(tail)]
-          + problem.distance_matrix[solution.Customer(successor)][solution.Customer(head)];
+        = problem.distance_matrix(solution.Customer(predecessor), solution.Customer(tail))
+          + problem.distance_matrix(solution.Customer(successor), solution.Customer(head));
     // Update if reversed insertion is more beneficial
     if (reversed_delta < insertion_delta) {
       insertion_delta = reversed_delta;
@@ -0,0 +1,63 @@
+#include "../include/neighbor_lists.h"
+
+#include <algorithm>
+
+// Whether customer a is closer to the customer than b, ties broken by index
+static bool Closer(const Problem &problem, Node customer, Node a, Node b)
+{
+    int distance_a = problem.distance_matrix(customer, a);
+    int distance_b = problem.distance_matrix(customer, b);
+    return distance_a < distance_b || (distance_a == distance_b && a < b);
+}
+
+// Build the lists of the num_neighbors nearest customers
+NeighborLists::NeighborLists(const Problem &problem, int num_neighbors)
+    : size_(problem.num_customers), lists_(problem.num_customers)
+{
+    // With as many neighbors as customers the restriction would accept every move
+    int num_candidates = problem.num_customers - 2;
+    granular_ = num_neighbors > 0 && num_neighbors < num_candidates;
+    if (!granular_) return;
+
+    bits_.assign((size_ * size_ + 63) / 64, 0);
+    auto set_bit = [&](Node a, Node b)
+    {
+        size_t bit = static_cast<size_t>(a) * size_ + b;
+        bits_[bit >> 6] |= uint64_t{1} << (bit & 63);
+    };
+
+    std::vector<Node> candidates;
+    for (Node customer = 1; customer < problem.num_customers; ++customer)
+    {
+        candidates.clear();
+        for (Node other = 1; other < problem.num_customers; ++other)
+        {
+            if (other != customer) candidates.push_back(other);
+        }
+
+        // Ties are broken by index, so the lists do not depend on the sort implementation
+        std::partial_sort(candidates.begin(), candidates.begin() + num_neighbors, candidates.end(),
+                          [&](Node a, Node b) { return Closer(problem, customer, a, b); });
+
+        // Visits of the same customer are always neighbors of each other
+        set_bit(customer, customer);
+        for (int i = 0; i < num_neighbors; ++i)
+        {
+            set_bit(customer, candidates[i]);
+            set_bit(candidates[i], customer);
+        }
+    }
+
+    // The lists hold both directions of the relation, closest first
+    for (Node customer = 1; customer < problem.num_customers; ++customer)
+    {
+        candidates.clear();
+        for (Node other = 1; other < problem.num_customers; ++other)
+        {
+            if (IsNeighbor(customer, other)) candidates.push_back(other);
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [&](Node a, Node b) { return Closer(problem, customer, a, b); });
+        lists_[customer].assign(candidates.begin(), candidates.end());
+    }
+}
@@ -0,0 +1,44 @@
+#include "../include/rankings.h"
+
+#include <algorithm>
+#include <numeric>
+
+// Rank the customers by a key, smallest first. Customers with equal keys share a rank, so sorting
+// by rank orders them as sorting by the key would.
+template <class Key> static std::vector<int> DenseRanks(const Problem &problem, Key key)
+{
+    std::vector<Node> customers(problem.num_customers - 1);
+    std::iota(customers.begin(), customers.end(), 1);
+    std::sort(customers.begin(), customers.end(), [&](Node a, Node b) { return key(a) < key(b); });
+
+    std::vector<int> ranks(problem.num_customers);
+    for (size_t i = 1; i < customers.size(); ++i)
+        ranks[customers[i]] = ranks[customers[i - 1]] + (key(customers[i - 1]) < key(customers[i]));
+    return ranks;
+}
+
+// Rank the depth nearest customers of every customer
+Rankings::Rankings(const Problem &problem, int depth) : nearest_(problem.num_customers)
+{
+    int num_ranked = problem.num_customers - 1;
+    if (depth > 0) num_ranked = std::min(depth, num_ranked);
+
+    std::vector<Node> candidates(problem.num_customers - 1);
+    for (Node customer = 0; customer < problem.num_customers; ++customer)
+    {
+        std::iota(candidates.begin(), candidates.end(), 1);
+
+        // Ties are broken by index, so the lists do not depend on the sort implementation
+        auto closer = [&](Node a, Node b)
+        {
+            int distance_a = problem.distance_matrix(customer, a);
+            int distance_b = problem.distance_matrix(customer, b);
+            return distance_a < distance_b || (distance_a == distance_b && a < b);
+        };
+        std::partial_sort(candidates.begin(), candidates.begin() + num_ranked, candidates.end(), closer);
+        nearest_[customer].assign(candidates.begin(), candidates.begin() + num_ranked);
+    }
+
+    depot_distance_ranks_ = DenseRanks(problem, [&](Node customer) { return problem.distance_matrix(0, customer); });
+    demand_ranks_ = DenseRanks(problem, [&](Node customer) { return problem.demands[customer]; });
+}
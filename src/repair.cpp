@@ -1,6 +1,6 @@
 #include "../include/repair.h"
 
-#include <map>
+#include "../include/epoch_table.h"
 
 // Merges consecutive nodes with the same customer in a route by combining their loads.
 void MergeAdjacentSameCustomers([[maybe_unused]] const Problem &problem, Node route_index,
@@ -33,9 +33,9 @@ int CalcRemovalDelta(const Problem &problem, const SpecificSolution &solution, N
     Node predecessor = solution.Predecessor(node_index);
     Node successor = solution.Successor(node_index);
     // Delta = new distance after removal - current distance
-    return problem.distance_matrix[solution.Customer(predecessor)][solution.Customer(successor)] -
-           problem.distance_matrix[solution.Customer(predecessor)][solution.Customer(node_index)] -
-           problem.distance_matrix[solution.Customer(node_index)][solution.Customer(successor)];
+    return problem.distance_matrix(solution.Customer(predecessor), solution.Customer(successor)) -
+           problem.distance_matrix(solution.Customer(predecessor), solution.Customer(node_index)) -
+           problem.distance_matrix(solution.Customer(node_index), solution.Customer(successor));
 }
 
 // Repairs a route by merging duplicate customers and optimizing node placements.
@@ -49,7 +49,10 @@ void Repair(const Problem &problem, Node route_index, SpecificSolution &solution
     // Step 1: Merge adjacent nodes with the same customer
     MergeAdjacentSameCustomers(problem, route_index, solution, context);
 
-    std::map<Node, Node> customer_node_map; // Maps customers to their last seen node
+    // Last seen node of every customer, zero if unseen. The table belongs to the calling thread
+    // and is cleared for every route by starting a new epoch.
+    static thread_local EpochTable<Node> customer_node_map;
+    customer_node_map.Reset(problem.num_customers);
     Node node_index = context.Head(route_index);
     solution.SetSuccessor(0, node_index); // Link the dummy start node to the head
 
@@ -57,17 +60,23 @@ void Repair(const Problem &problem, Node route_index, SpecificSolution &solution
     {
         Node successor = solution.Successor(node_index);
         Node customer = solution.Customer(node_index);
-        auto it = customer_node_map.find(customer);
 
-        if (it == customer_node_map.end())
+        // A customer with a single visit has no duplicate to merge
+        if (!solution.NextVisit(solution.FirstVisit(customer)))
+        {
+            node_index = successor;
+            continue;
+        }
+        Node &last_node_index = customer_node_map[customer];
+
+        if (!last_node_index)
         {
             // First occurrence of this customer
-            customer_node_map[customer] = node_index;
+            last_node_index = node_index;
         }
         else
         {
             // Merge with the better option based on removal delta
-            Node &last_node_index = it->second;
             if (CalcRemovalDelta(problem, solution, last_node_index) < CalcRemovalDelta(problem, solution, node_index))
             {
                 std::swap(last_node_index, node_index);
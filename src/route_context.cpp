@@ -1,5 +1,32 @@
 #include "../include/route_context.h"
 
+#include <algorithm>
+#include <cmath>
+
+static constexpr int kFullTurn = 65536; // Polar angles are measured in 1/65536 of a turn
+
+// Reduce an angle to [0, kFullTurn)
+static int PositiveMod(int angle)
+{
+    return (angle % kFullTurn + kFullTurn) % kFullTurn;
+}
+
+// Precompute the polar angle of each customer around the depot, if the locations are known
+RouteContext::RouteContext(const Problem &problem) : problem_(&problem)
+{
+    if (problem.coordinates.empty())
+        return;
+
+    polar_angles_.resize(problem.num_customers);
+    auto [depot_x, depot_y] = problem.coordinates[0];
+    for (Node customer = 0; customer < problem.num_customers; ++customer)
+    {
+        auto [x, y] = problem.coordinates[customer];
+        double angle = std::atan2(y - depot_y, x - depot_x);
+        polar_angles_[customer] = PositiveMod(static_cast<int>(std::lround(angle * kFullTurn / (2 * M_PI))));
+    }
+}
+
 // Return the head node of the route
 Node RouteContext::Head(Node route_index) const
 {
@@ -24,6 +51,51 @@ int RouteContext::PreLoad(Node node_index) const
     return pre_loads_[node_index];
 }
 
+// Return the route of a node, as of the last UpdateRouteContext or MoveRouteContext of its route
+Node RouteContext::RouteIndex(Node node_index) const
+{
+    return route_indices_[route_ids_[node_index]];
+}
+
+// Return the position of a node in its route, counted from zero at the head
+int RouteContext::Position(Node node_index) const
+{
+    return positions_[node_index];
+}
+
+// Return the number of nodes of the route, as of its last UpdateRouteContext
+int RouteContext::Length(Node route_index) const
+{
+    Node tail = routes_[route_index].tail;
+    return tail ? positions_[tail] + 1 : 0;
+}
+
+// Return the travel cost of the route, as of its last UpdateRouteContext
+int RouteContext::Cost(Node route_index) const
+{
+    return routes_[route_index].cost;
+}
+
+// Return the total travel cost of all routes
+int RouteContext::Objective() const
+{
+    return objective_;
+}
+
+// Check whether two routes can interact, as in the SWAP* neighborhood. Without locations every pair overlaps
+bool RouteContext::Overlap(Node route_a, Node route_b) const
+{
+    if (polar_angles_.empty())
+        return true;
+
+    const RouteData &a = routes_[route_a];
+    const RouteData &b = routes_[route_b];
+    bool sectors = PositiveMod(b.sector.start - a.sector.start) <= PositiveMod(a.sector.end - a.sector.start)
+                   || PositiveMod(a.sector.start - b.sector.start) <= PositiveMod(b.sector.end - b.sector.start);
+    bool boxes = a.min_x <= b.max_x && b.min_x <= a.max_x && a.min_y <= b.max_y && b.min_y <= a.max_y;
+    return sectors && boxes;
+}
+
 // Set the head of a given route
 void RouteContext::SetHead(Node route_index, Node head)
 {
@@ -45,19 +117,50 @@ Node RouteContext::NumRoutes() const
 // Set the number of routes
 void RouteContext::SetNumRoutes(Node num_routes) 
 {
-    routes_.resize(num_routes);
+    for (Node route_index = num_routes; route_index < NumRoutes(); ++route_index)
+    {
+        objective_ -= routes_[route_index].cost;
+        free_route_ids_.emplace_back(routes_[route_index].id);
+    }
+
+    Node old_num_routes = NumRoutes();
+    routes_.resize(num_routes, RouteData{0, 0, 0, 0});
+    for (Node route_index = old_num_routes; route_index < num_routes; ++route_index)
+        routes_[route_index].id = NewRouteId(route_index);
 }
 
-// Add a new route
+// Add a new route. Its cost is calculated by UpdateRouteContext
 void RouteContext::AddRoute(Node head, Node tail, int load)
 {
-    routes_.emplace_back(RouteData{head, tail, load});
+    routes_.emplace_back(RouteData{head, tail, load, 0});
+    routes_.back().id = NewRouteId(NumRoutes() - 1);
+}
+
+// Take an id of a dropped route, or a new one, and map it to the route index
+Node RouteContext::NewRouteId(Node route_index)
+{
+    Node id;
+    if (free_route_ids_.empty())
+    {
+        id = route_indices_.size();
+        route_indices_.emplace_back();
+    }
+    else
+    {
+        id = free_route_ids_.back();
+        free_route_ids_.pop_back();
+    }
+    route_indices_[id] = route_index;
+    return id;
 }
 
 // Calculate the context of the route, given the current solution
 void RouteContext::CalcRouteContext(const SpecificSolution& solution)
 {
     routes_.clear();
+    route_indices_.clear();
+    free_route_ids_.clear();
+    objective_ = 0;
 
     // Add a new route if the node has no predecessor (node is the head)
     for (Node node_index : solution.NodeIndices())
@@ -66,39 +169,101 @@ void RouteContext::CalcRouteContext(const SpecificSolution& solution)
             AddRoute(node_index, node_index, 0);
     }
 
-    pre_loads_.resize(solution.MaxNodeIndex() + 1);
+    ResizeNodes(solution);
 
     // Updat route context for each of the routes that are added
     for (Node route_index = 0; route_index < NumRoutes(); ++route_index)
         UpdateRouteContext(solution, route_index, 0);
 }
 
+// Size the arrays of the nodes to the nodes of the solution. Updates do not resize them, so that the
+// routes can be updated concurrently, and nodes created since the last call must be sized here first.
+void RouteContext::ResizeNodes(const SpecificSolution& solution)
+{
+    pre_loads_.resize(solution.MaxNodeIndex() + 1);
+    pre_costs_.resize(solution.MaxNodeIndex() + 1);
+    route_ids_.resize(solution.MaxNodeIndex() + 1);
+    positions_.resize(solution.MaxNodeIndex() + 1);
+}
+
 // Update route context of a given route, with respect to the current solution
 void RouteContext::UpdateRouteContext(const SpecificSolution& solution, Node route_index, Node predecessor)
 {
-    pre_loads_.resize(solution.MaxNodeIndex() + 1);
+    Node route_id = routes_[route_index].id;
     int load = pre_loads_[predecessor];
+    int cost = pre_costs_[predecessor];
+    int position = predecessor ? positions_[predecessor] + 1 : 0;
+    bool head = !predecessor; // The geometry is recalculated from the head, and extended otherwise
 
     Node node_index = predecessor ? solution.Successor(predecessor) : Head(route_index);
     
     // Iterate through all nodes of the route
     while (node_index) 
     {
-        // Update load and preload
+        // Update load and preload, cost and precost
         load += solution.Load(node_index);
         pre_loads_[node_index] = load;
+        cost += problem_->distance_matrix(solution.Customer(predecessor), solution.Customer(node_index));
+        pre_costs_[node_index] = cost;
+        route_ids_[node_index] = route_id;
+        positions_[node_index] = position++;
+        ExtendRouteGeometry(route_index, solution.Customer(node_index), head);
+        head = false;
       
         predecessor = node_index;
         node_index = solution.Successor(node_index);
     }
+    cost += problem_->distance_matrix(solution.Customer(predecessor), 0); // Return to the depot
     
-    // Set the tail and total load
-    routes_[route_index].tail = predecessor;
-    routes_[route_index].load = load;
+    // Set the tail, total load and cost
+    RouteData &route = routes_[route_index];
+    route.tail = predecessor;
+    route.load = load;
+    objective_ += cost - route.cost;
+    route.cost = cost;
+}
+
+// Extend the polar sector and bounding box of a route by a customer, or start them at the head.
+// Updates after a predecessor only extend them, so they may still cover customers removed from the
+// route until the next update from the head. Overlap stays true for every pair that can interact.
+void RouteContext::ExtendRouteGeometry(Node route_index, Node customer, bool head)
+{
+    if (polar_angles_.empty())
+        return;
+
+    RouteData &route = routes_[route_index];
+    int angle = polar_angles_[customer];
+    auto [x, y] = problem_->coordinates[customer];
+    if (head)
+    {
+        route.sector = {angle, angle};
+        route.min_x = route.max_x = x;
+        route.min_y = route.max_y = y;
+        return;
+    }
+
+    // Extend the sector by the smaller of the two arcs reaching the angle
+    Sector &sector = route.sector;
+    if (PositiveMod(angle - sector.start) > PositiveMod(sector.end - sector.start))
+    {
+        if (PositiveMod(angle - sector.end) <= PositiveMod(sector.start - angle))
+            sector.end = angle;
+        else
+            sector.start = angle;
+    }
+
+    route.min_x = std::min(route.min_x, x);
+    route.max_x = std::max(route.max_x, x);
+    route.min_y = std::min(route.min_y, y);
+    route.max_y = std::max(route.max_y, y);
 }
 
-// Copy the route at src_route_index to dest_route_index
+// Move the route at src_route_index to dest_route_index. The route at dest_route_index moves to
+// src_route_index and stays counted in the objective until it is overwritten or dropped by SetNumRoutes.
+// The nodes keep the id of their route, so only the ids of the two routes are mapped again.
 void RouteContext::MoveRouteContext(Node dest_route_index, Node src_route_index)
 {
-    routes_[dest_route_index] = routes_[src_route_index];
+    std::swap(routes_[dest_route_index], routes_[src_route_index]);
+    route_indices_[routes_[dest_route_index].id] = dest_route_index;
+    route_indices_[routes_[src_route_index].id] = src_route_index;
 }
\ No newline at end of file
@@ -1,39 +1,34 @@
 #include <algorithm>
-#include <random>
 #include <numeric>
-#include <set>
 #include <vector>
 #include <iostream>
 
 #include "../include/ruin_method.h"
+#include "../include/random_engine.h"
 #include "../include/route_context.h"
 
 // Random ruin strategy to perturb a random number of customers.
 RandomRuin::RandomRuin(vector<int> num_perturb_customers)
       : num_perturb_customers_(move(num_perturb_customers)) {}
 
-vector<Node> RandomRuin::Ruin(const Problem &problem, SpecificSolution &solution,
-                                RouteContext &context)                                      
+void RandomRuin::Ruin(const Problem &problem, [[maybe_unused]] const Rankings &rankings,
+                      SpecificSolution &solution, RouteContext &context, vector<Node> &customers)
 {
     // Select a random number of customers to perturb
     int num_perturb = num_perturb_customers_.size() > 0 
-                        ? num_perturb_customers_[rand() % num_perturb_customers_.size()]
-                        : num_perturb_customers_[rand() % (num_perturb_customers_.size() + 1)];
+                        ? num_perturb_customers_[ThreadRandom().Below(num_perturb_customers_.size())]
+                        : num_perturb_customers_[ThreadRandom().Below(num_perturb_customers_.size() + 1)];
     
-    vector<Node> customers(problem.num_customers - 1);
+    customers.resize(problem.num_customers - 1);
 
     // Fill the customers vector with indices starting from 1
     iota(customers.begin(), customers.end(), 1);
 
     // Shuffle the customer indices
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    shuffle(customers.begin(), customers.end(), gen);
+    shuffle(customers.begin(), customers.end(), ThreadRandom());
 
     // Keep only the number of customers to perturb
     customers.erase(customers.begin() + num_perturb, customers.end());
-
-    return customers;
 }
 
 // SISRS ruin strategy to remove structured groups of customers from routes.
@@ -44,77 +39,78 @@ SisrsRuin::SisrsRuin(int average_customers, int max_length, double split_rate,
         split_rate_(split_rate),
         preserved_probability_(preserved_probability) {}
 
-vector<Node> SisrsRuin::Ruin(const Problem &problem, SpecificSolution &solution,
-                                RouteContext &context)
+void SisrsRuin::Ruin(const Problem &problem, const Rankings &rankings, SpecificSolution &solution,
+                     RouteContext &context, vector<Node> &customer_indices)
 {
+    static thread_local vector<Node> visited_routes; // Keep track of visited routes, reused by every ruin
+
     // Calculate average and max route lengths
     double average_length = static_cast<double>(problem.num_customers - 1) / context.NumRoutes();
     double max_length = min(static_cast<double>(max_length_), average_length);
 
     // Calculate the number of strings to ruin
     double max_strings = 4.0 * average_customers_ / (1 + max_length_) - 1;
-    size_t num_strings = static_cast<size_t>((static_cast<double>(rand()) / RAND_MAX) * max_strings) + 1;
+    size_t num_strings = static_cast<size_t>(ThreadRandom().Uniform() * max_strings) + 1;
 
     // Randomly select a seed customer
-    int customer_seed = rand() % (problem.num_customers);
-
-    vector<Node> node_indices(solution.NodeIndices());
-    auto &&seed_distances = problem.distance_matrix[customer_seed];
+    int customer_seed = ThreadRandom().Below(problem.num_customers);
 
-    // Sort nodes based on distance to the seed customer
-    stable_sort(node_indices.begin(), node_indices.end(), [&](Node lhs, Node rhs) {
-        return seed_distances[solution.Customer(lhs)] < seed_distances[solution.Customer(rhs)];
-    });
+    visited_routes.clear();
+    customer_indices.clear();
 
-    set<Node> visited_heads; // Keep track of visited route heads
-    vector<Node> route;
-    vector<Node> customer_indices;
-
-    // Process each node and ruin segments
-    for (Node node_index : node_indices)
+    // Process the nodes of the customers nearest to the seed first and ruin segments. With ranked
+    // lists shorter than the customers, the ruin may end with fewer strings.
+    for (Node customer : rankings.Nearest(customer_seed))
     {
-        if (visited_heads.size() >= num_strings)
+        if (visited_routes.size() >= num_strings)
             break;
 
-        int position;
-        int head = GetRouteHead(solution, node_index, position);
-
-        if (!visited_heads.insert(head).second)
-            continue;
+        for (Node node_index = solution.FirstVisit(customer); node_index && visited_routes.size() < num_strings;
+             node_index = solution.NextVisit(node_index))
+        {
+            Node route_index = context.RouteIndex(node_index);
 
-        GetRoute(solution, head, route);
+            // The strings are few, so the routes are searched linearly
+            if (find(visited_routes.begin(), visited_routes.end(), route_index) != visited_routes.end())
+                continue;
+            visited_routes.emplace_back(route_index);
 
-        int route_length = static_cast<int>(route.size());
-        double max_ruin_length = min(static_cast<double>(route_length), max_length);
+            int position = context.Position(node_index);
+            int route_length = context.Length(route_index);
+            double max_ruin_length = min(static_cast<double>(route_length), max_length);
 
-        // Calculate ruin length and determine preserved segments
-        int ruin_length = static_cast<int>((static_cast<double>(rand()) / RAND_MAX) * max_ruin_length) + 1;
-        int num_preserved = 0;
-        int preserved_start_position = -1;
+            // Calculate ruin length and determine preserved segments
+            int ruin_length = static_cast<int>(ThreadRandom().Uniform() * max_ruin_length) + 1;
+            int num_preserved = 0;
+            int preserved_start_position = -1;
 
-        if (ruin_length >= 2 && ruin_length < route_length && 
-            (static_cast<double>(rand()) / RAND_MAX) < split_rate_)
-        {
-            while (ruin_length < route_length)
+            if (ruin_length >= 2 && ruin_length < route_length && 
+                ThreadRandom().Uniform() < split_rate_)
             {
-                if ((static_cast<double>(rand()) / RAND_MAX) < preserved_probability_)
-                    break;
-
-                ++num_preserved;
-                ++ruin_length;
+                while (ruin_length < route_length)
+                {
+                    if (ThreadRandom().Uniform() < preserved_probability_)
+                        break;
+
+                    ++num_preserved;
+                    ++ruin_length;
+                }
+                preserved_start_position = ThreadRandom().Below(max(1, ruin_length - num_preserved - 1)) + 1;
             }
-            preserved_start_position = (rand() % max(1, ruin_length - num_preserved - 1)) + 1;
-        }
 
-        int min_start_position = max(0, position - ruin_length + 1);
-        int max_start_position = min(route_length - ruin_length, position);
-        int start_position = (rand() % (max_start_position - min_start_position + 1)) + min_start_position;
+            int min_start_position = max(0, position - ruin_length + 1);
+            int max_start_position = min(route_length - ruin_length, position);
+            int start_position = ThreadRandom().Below(max_start_position - min_start_position + 1) + min_start_position;
 
-        // Collect ruined customer indices
-        for (int j = 0; j < ruin_length; ++j)
-        {
-            if (j < preserved_start_position || j >= preserved_start_position + num_preserved)
-                customer_indices.emplace_back(solution.Customer(route[start_position + j]));
+            // Walk back from the node to the start of the string and collect ruined customer indices
+            Node string_node = node_index;
+            for (int j = position; j > start_position; --j)
+                string_node = solution.Predecessor(string_node);
+            for (int j = 0; j < ruin_length; ++j, string_node = solution.Successor(string_node))
+            {
+                if (j < preserved_start_position || j >= preserved_start_position + num_preserved)
+                    customer_indices.emplace_back(solution.Customer(string_node));
+            }
         }
     }
 
@@ -122,34 +118,5 @@ vector<Node> SisrsRuin::Ruin(const Problem &problem, SpecificSolution &solution,
     sort(customer_indices.begin(), customer_indices.end());
     customer_indices.erase(unique(customer_indices.begin(), customer_indices.end()), customer_indices.end());
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    shuffle(customer_indices.begin(), customer_indices.end(), gen);
-
-    return customer_indices;
-}
-
-// Get the head of the route containing the node and its position in the route.
-Node SisrsRuin::GetRouteHead(SpecificSolution &solution, Node node_index, int &position)
-{
-    position = 0;
-    while (true)
-    {
-        Node predecessor = solution.Predecessor(node_index);
-        if (!predecessor)
-            return node_index;
-        node_index = predecessor;
-        ++position;
-    }
-}
-
-// Get the entire route starting from the head node.
-void SisrsRuin::GetRoute(const SpecificSolution &solution, Node head, vector<Node> &route)
-{
-    route.clear();
-    while (head)
-    {
-        route.emplace_back(head);
-        head = solution.Successor(head);
-    }
+    shuffle(customer_indices.begin(), customer_indices.end(), ThreadRandom());
 }
@@ -0,0 +1,107 @@
+#include "../include/setup.h"
+
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Read problem data from a file
+Problem ReadProblemFromFile(const string &problem_path)
+{
+    ifstream ifs(problem_path);
+    if (ifs.fail())
+    {
+        throw invalid_argument("Cannot open problem.");
+    }
+
+    Problem problem{};
+    ifs >> problem.num_customers >> problem.capacity;
+    ++problem.num_customers; // Adjust for 0-indexing
+    problem.demands.resize(problem.num_customers);
+
+    // Read demands for each customer
+    for (Node i = 1; i < problem.num_customers; ++i)
+    {
+        ifs >> problem.demands[i];
+    }
+
+    // Read customer locations and compute distances
+    auto &customers = problem.coordinates;
+    customers.resize(problem.num_customers);
+    for (Node i = 0; i < problem.num_customers; ++i)
+    {
+        ifs >> customers[i].first >> customers[i].second;
+    }
+
+    vector<vector<int>> distances(problem.num_customers, vector<int>(problem.num_customers));
+    for (Node i = 0; i < problem.num_customers; ++i)
+    {
+        for (Node j = 0; j < problem.num_customers; ++j)
+        {
+            auto [x1, y1] = customers[i];
+            auto [x2, y2] = customers[j];
+            distances[i][j] = lround(hypot(x1 - x2, y1 - y2));
+        }
+    }
+    problem.distance_matrix = DistanceMatrix(distances);
+
+    return problem;
+}
+
+// Build the solver configuration used for every instance
+SpecificConfig MakeConfig(int num_threads)
+{
+    SpecificConfig config;
+
+    config.random_seed = 42;
+    config.time_limit = 10;
+    config.blink_rate = 0.021;
+    config.num_threads = num_threads;
+
+    // Add operators for optimization
+    config.inter_operators.push_back(make_unique<Relocate>());
+    config.inter_operators.push_back(make_unique<Swap<2, 0>>());
+    config.inter_operators.push_back(make_unique<Swap<2, 1>>());
+    config.inter_operators.push_back(make_unique<Swap<2, 2>>());
+    config.inter_operators.push_back(make_unique<Cross>());
+    config.inter_operators.push_back(make_unique<SwapStar>());
+    config.inter_operators.push_back(make_unique<SdSwapStar>());
+    config.inter_operators.push_back(make_unique<SdSwapOneOne>());
+    config.inter_operators.push_back(make_unique<SdSwapTwoOne>());
+
+    config.intra_operators.push_back(std::make_unique<Exchange>());
+    config.intra_operators.push_back(std::make_unique<OrOpt<1>>());
+    config.intra_operators.push_back(std::make_unique<OrOpt<2>>());
+    config.intra_operators.push_back(std::make_unique<OrOpt<3>>());
+
+    // Configure acceptance rule
+    auto length = static_cast<int>(83);
+    config.acceptance_rule = [length]()
+    {
+        return std::make_unique<LateAcceptanceHillClimbing>(length);
+    };
+
+    // Configure ruin and recreate method
+    auto average_customers = static_cast<int>(36);
+    auto max_length = static_cast<int>(8);
+    auto split_rate = 0.740;
+    auto preserved_probability = 0.096;
+
+    config.ruin_method = make_unique<SisrsRuin>(average_customers, max_length,
+                                                split_rate, preserved_probability);
+
+    // Configure sorting
+    Sorter sorter;
+    sorter.AddSortFunction(std::make_unique<SortByRandom>(), 0.078);
+    sorter.AddSortFunction(std::make_unique<SortByDemand>(), 0.225);
+    sorter.AddSortFunction(std::make_unique<SortByFar>(), 0.942);
+    sorter.AddSortFunction(std::make_unique<SortByClose>(), 0.120);
+
+    config.sorter = std::move(sorter);
+
+    return config;
+}
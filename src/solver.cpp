@@ -1,148 +1,319 @@
 #include "../include/solver.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <exception>
 #include <limits>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
-#include <random>
 
 #include "../include/cache.h"
 #include "../include/construction.h"
+#include "../include/random_engine.h"
+#include "../include/rankings.h"
 #include "../include/repair.h"
 #include "../include/split_reinsertion.h"
 #include "../include/utils.h"
 
+// Nanoseconds passed since the given start time.
+uint64_t ElapsedNanoseconds(std::chrono::steady_clock::time_point start_time)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time)
+        .count();
+}
+
+// Name of an inter-operator in the trace, or null without a tracer.
+const char *TraceName(const SpecificConfig &config, int neighborhood)
+{
+    return config.tracer ? config.tracer->Intern(config.inter_operators[neighborhood]->Name()) : nullptr;
+}
+
 // Searches for improvements within a single route.
 void IntraRouteSearch(const Problem &problem, const SpecificConfig &config, Node route_index,
-                        SpecificSolution &solution, RouteContext &context) 
+                        SpecificSolution &solution, RouteContext &context, const SearchContext &search) 
 {
+    TraceScope trace(config.tracer, "IntraRouteSearch");
     Repair(problem, route_index, solution, context); // Repair the route first.
-    vector<Node> intra_neighborhoods(config.intra_operators.size());
+    static thread_local vector<Node> intra_neighborhoods; // Reused by every search of the thread
+    intra_neighborhoods.resize(config.intra_operators.size());
     iota(intra_neighborhoods.begin(), intra_neighborhoods.end(), 0);
+    StatisticsRecorder *statistics = search.statistics;
+    uint64_t num_evaluations = 0;
     
-    while (true) 
+    while (!search.IsCancelled()) 
     {
         // Randomize the order of neighborhoods to explore.
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        shuffle(intra_neighborhoods.begin(), intra_neighborhoods.end(), gen);
+        shuffle(intra_neighborhoods.begin(), intra_neighborhoods.end(), ThreadRandom());
         
         bool improved = false;
         
         // Try each neighborhood operator.
         for (Node neighborhood : intra_neighborhoods) 
         {
+            auto start_time = statistics ? std::chrono::steady_clock::now()
+                                         : std::chrono::steady_clock::time_point{};
+            int cost = context.Cost(route_index);
             improved = (*config.intra_operators[neighborhood])(problem, route_index, solution, context);
+            ++num_evaluations;
+            if (statistics)
+            {
+                statistics->RecordIntra(neighborhood, ElapsedNanoseconds(start_time),
+                                        cost - context.Cost(route_index));
+            }
             if (improved) break; // Stop if any improvement is found.
         }
 
         if (!improved) break; // Exit if no improvements are possible.
     }
+
+    if (search.stopping) search.stopping->AddEvaluations(num_evaluations);
+}
+
+// Searches every route on the pool. The routes share no nodes, so each thread changes its routes
+// apart and the changes are merged in route order afterwards.
+void ParallelIntraRouteSearch(const Problem &problem, const SpecificConfig &config, SpecificSolution &solution,
+                              RouteContext &context, ThreadPool &pool, const SearchContext &search)
+{
+    // Buffers of the routes, owned by the calling thread and handed to the workers by reference
+    static thread_local vector<SpecificSolution::RouteChanges> buffers;
+    auto &changes = buffers;
+    changes.resize(std::max<size_t>(changes.size(), context.NumRoutes()));
+    // The node arrays of the context were sized by CalcRouteContext, so the workers only write entries.
+    DeterministicParallelFor(pool, context.NumRoutes(), [&](size_t route_index)
+    {
+        solution.BeginRouteChanges(changes[route_index]);
+        IntraRouteSearch(problem, config, route_index, solution, context, search);
+        solution.EndRouteChanges();
+    });
+
+    for (Node route_index = 0; route_index < context.NumRoutes(); ++route_index)
+        solution.MergeRouteChanges(changes[route_index]);
+}
+
+// Evaluates every inter-operator on the same solution, on the pool if there is one, and applies the
+// best improving move into routes. Ties between operators are broken randomly, as within an operator.
+bool ApplyBestInterMove(const Problem &problem, const SpecificConfig &config, SpecificSolution &solution,
+                        RouteContext &context, CacheMap &cache_map, const SearchContext &search,
+                        const vector<int> &inter_neighborhoods, ModifiedRoutes &routes)
+{
+    // The caches shared by the operators are filled first, so the evaluations only read them.
+    for (int neighborhood : inter_neighborhoods)
+        config.inter_operators[neighborhood]->Prepare(problem, solution, context, cache_map, search);
+
+    // Buffers of the calling thread, handed to the workers by reference
+    static thread_local vector<InterMove> move_buffer;
+    static thread_local vector<uint64_t> nanosecond_buffer;
+    auto &moves = move_buffer;
+    auto &nanoseconds = nanosecond_buffer;
+    moves.resize(inter_neighborhoods.size());
+    nanoseconds.resize(inter_neighborhoods.size());
+    auto evaluate = [&](size_t i, const SearchContext &operator_search)
+    {
+        TraceScope trace(config.tracer, TraceName(config, inter_neighborhoods[i]));
+        auto start_time = std::chrono::steady_clock::now();
+        moves[i] = config.inter_operators[inter_neighborhoods[i]]->Evaluate(problem, solution, context,
+                                                                             cache_map, operator_search);
+        nanoseconds[i] = ElapsedNanoseconds(start_time);
+    };
+
+    if (search.pool)
+    {
+        // The operators take up the pool, so each evaluates its route pairs sequentially.
+        SearchContext operator_search{search.neighbors, nullptr, search.statistics, search.stopping};
+        DeterministicParallelFor(*search.pool, moves.size(), [&](size_t i) { evaluate(i, operator_search); });
+    }
+    else
+    {
+        for (size_t i = 0; i < moves.size(); ++i)
+            evaluate(i, search);
+    }
+
+    if (search.stopping) search.stopping->AddEvaluations(moves.size());
+
+    Delta<int> best_delta{};
+    InterMove *best_move = nullptr;
+    for (InterMove &move : moves)
+    {
+        if (move.Improves() && best_delta.Update(move.delta))
+            best_move = &move;
+    }
+
+    // Only the applied move counts as an improvement.
+    if (search.statistics)
+    {
+        for (size_t i = 0; i < moves.size(); ++i)
+        {
+            int improvement = &moves[i] == best_move ? -moves[i].delta.value : 0;
+            search.statistics->RecordInter(inter_neighborhoods[i], nanoseconds[i], improvement);
+        }
+    }
+    if (best_move) routes = best_move->apply(solution, context);
+    return best_move != nullptr;
 }
 
 // Randomized exploration of neighborhoods to find better solutions.
 void RandomizedVariableNeighborhoodDescent(const Problem &problem, const SpecificConfig &config,
                                             SpecificSolution &solution, RouteContext &context,
-                                            CacheMap &cache_map) 
+                                            CacheMap &cache_map, const SearchContext &search) 
 {
-    cache_map.Reset(solution, context); // Reset cache for the current solution.
+    {
+        TraceScope trace(config.tracer, "Cache reset");
+        cache_map.Reset(solution, context); // Reset cache for the current solution.
+    }
+
+    // Buffers of the calling thread, reused by every pass
+    static thread_local vector<int> inter_neighborhoods;
+    static thread_local vector<Node> heads;
 
-    while (true) 
+    while (!search.IsCancelled()) 
     {
-        vector<int> inter_neighborhoods(config.inter_operators.size());
+        inter_neighborhoods.resize(config.inter_operators.size());
         iota(inter_neighborhoods.begin(), inter_neighborhoods.end(), 0);
 
         // Shuffle the neighborhoods to ensure randomness.
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        shuffle(inter_neighborhoods.begin(), inter_neighborhoods.end(), gen);
-        
-        bool improved = false;
+        shuffle(inter_neighborhoods.begin(), inter_neighborhoods.end(), ThreadRandom());
         
-        for (int neighborhood : inter_neighborhoods) 
+        Node original_num_routes = context.NumRoutes();
+        ModifiedRoutes routes;
+        bool moved = false;
+
+        if (config.concurrent_operators)
+        {
+            moved = ApplyBestInterMove(problem, config, solution, context, cache_map, search, inter_neighborhoods,
+                                       routes);
+        }
+        else
         {
-            Node original_num_routes = context.NumRoutes();
-            auto routes = (*config.inter_operators[neighborhood])(problem, solution, context, cache_map);
-            
-            if (!routes.empty()) 
+            // Apply the first operator that improves.
+            for (int neighborhood : inter_neighborhoods) 
             {
-                sort(routes.begin(), routes.end()); // Sort routes for consistency.
-                improved = true;
-                vector<Node> heads;
-                
-                for (Node route_index : routes) 
+                TraceScope trace(config.tracer, TraceName(config, neighborhood));
+                auto start_time = search.statistics ? std::chrono::steady_clock::now()
+                                                    : std::chrono::steady_clock::time_point{};
+                InterMove move = config.inter_operators[neighborhood]->Evaluate(problem, solution, context,
+                                                                                  cache_map, search);
+                if (move.Improves())
                 {
-                    Node head = context.Head(route_index);
-                    if (head) heads.emplace_back(head);
-                    if (route_index < original_num_routes) cache_map.RemoveRoute(route_index);
+                    routes = move.apply(solution, context);
+                    moved = true;
                 }
-
-                Node num_routes = 0;
-                
-                // Compact routes by removing unused ones.
-                for (Node route_index = 0; route_index < context.NumRoutes(); ++route_index) 
+                if (search.stopping) search.stopping->AddEvaluations(1);
+                if (search.statistics)
                 {
-                    if (find(routes.begin(), routes.end(), route_index) == routes.end()) 
-                    {
-                        context.MoveRouteContext(num_routes, route_index);
-                        cache_map.MoveRoute(num_routes, route_index);
-                        ++num_routes;
-                    }
+                    search.statistics->RecordInter(neighborhood, ElapsedNanoseconds(start_time),
+                                                   -move.delta.value);
                 }
+                if (moved || search.IsCancelled()) break;
+            }
+        }
 
-                // Add back updated routes and perform intra-route search.
-                for (Node head : heads) 
-                {
-                    context.SetHead(num_routes, head);
-                    context.UpdateRouteContext(solution, num_routes, 0);
-                    cache_map.AddRoute(num_routes);
-                    IntraRouteSearch(problem, config, num_routes, solution, context);
-                    ++num_routes;
-                }
+        if (!moved) break; // Exit if no improvements are made.
+
+        sort(routes.begin(), routes.end()); // Sort routes for consistency.
+        heads.clear();
+        
+        for (Node route_index : routes) 
+        {
+            Node head = context.Head(route_index);
+            if (head) heads.emplace_back(head);
+            if (route_index < original_num_routes) cache_map.RemoveRoute(route_index);
+        }
 
-                context.SetNumRoutes(num_routes); // Update route count.
-                break;
+        Node num_routes = 0;
+        
+        // Compact routes by removing unused ones.
+        for (Node route_index = 0; route_index < context.NumRoutes(); ++route_index) 
+        {
+            if (find(routes.begin(), routes.end(), route_index) == routes.end()) 
+            {
+                context.MoveRouteContext(num_routes, route_index);
+                cache_map.MoveRoute(num_routes, route_index);
+                ++num_routes;
             }
         }
 
-        if (!improved) break; // Exit if no improvements are made.
+        // Add back updated routes and perform intra-route search. The move may have created nodes.
+        context.ResizeNodes(solution);
+        for (Node head : heads) 
+        {
+            context.SetHead(num_routes, head);
+            context.UpdateRouteContext(solution, num_routes, 0);
+            cache_map.AddRoute(num_routes);
+            IntraRouteSearch(problem, config, num_routes, solution, context, search);
+            ++num_routes;
+        }
+
+        context.SetNumRoutes(num_routes); // Update route count.
     }
 
     cache_map.Save(solution, context); // Save the final state of the cache.
 }
 
-// Introduce changes to the solution to escape local optima.
-void Perturb(const Problem &problem, const SpecificConfig &config, SpecificSolution &solution,
-               RouteContext &context) 
+// Improve a solution by searching every route and then the neighborhoods between routes.
+void LocalSearch(const Problem &problem, const SpecificConfig &config, SpecificSolution &solution,
+                 RouteContext &context, CacheMap &cache_map, const SearchContext &search)
 {
-    context.CalcRouteContext(solution); // Update the context.
-    vector<Node> customers = config.ruin_method->Ruin(problem, solution, context); // Ruin part of the solution.
-    config.sorter.Sort(problem, customers); // Sort customers for reinsertion.
+    TraceScope trace(config.tracer, "LocalSearch");
+    context.CalcRouteContext(solution);
+
+    if (search.pool)
+        ParallelIntraRouteSearch(problem, config, solution, context, *search.pool, search);
+    else
+    {
+        for (Node i = 0; i < context.NumRoutes(); ++i)
+            IntraRouteSearch(problem, config, i, solution, context, search); // Improve routes.
+    }
+
+    TraceScope rvnd_trace(config.tracer, "RVND");
+    RandomizedVariableNeighborhoodDescent(problem, config, solution, context, cache_map, search);
+}
 
-    // Remove customers from routes.
+// Remove every node of the customers from the routes, visiting only the nodes of the customers.
+void RemoveCustomers(SpecificSolution &solution, RouteContext &context, const vector<Node> &customers)
+{
     for (Node customer : customers) 
     {
-        for (Node route_index = 0; route_index < context.NumRoutes(); ++route_index) 
+        // Removing a node takes it out of the visits of the customer
+        while (Node node_index = solution.FirstVisit(customer)) 
         {
-            Node node_index = context.Head(route_index);
-            while (node_index) 
-            {
-                Node successor = solution.Successor(node_index);
-                
-                if (solution.Customer(node_index) == customer) 
-                {
-                    Node predecessor = solution.Predecessor(node_index);
-                    solution.Remove(node_index);
-                    if (predecessor == 0) context.SetHead(route_index, successor);
-                    context.UpdateRouteContext(solution, route_index, predecessor);
-                }
-                node_index = successor;
-            }
+            Node route_index = context.RouteIndex(node_index);
+            Node predecessor = solution.Predecessor(node_index);
+            Node successor = solution.Successor(node_index);
+            solution.Remove(node_index);
+            if (predecessor == 0) context.SetHead(route_index, successor);
+            context.UpdateRouteContext(solution, route_index, predecessor);
         }
     }
+}
+
+// Introduce changes to the solution to escape local optima.
+void Perturb(const Problem &problem, const SpecificConfig &config, const Rankings &rankings,
+             SpecificSolution &solution, RouteContext &context) 
+{
+    TraceScope trace(config.tracer, "Perturb");
+    context.CalcRouteContext(solution); // Update the context.
+    static thread_local vector<Node> customers; // Reused by every perturbation of the thread
+    {
+        TraceScope ruin_trace(config.tracer, "Ruin");
+        config.ruin_method->Ruin(problem, rankings, solution, context, customers); // Ruin part of the solution.
+    }
+    {
+        TraceScope sort_trace(config.tracer, "Sort");
+        config.sorter.Sort(problem, rankings, customers); // Sort customers for reinsertion.
+    }
+    {
+        TraceScope removal_trace(config.tracer, "Removal");
+        RemoveCustomers(solution, context, customers); // Remove customers from routes.
+    }
 
     // Reinsert customers using SplitReinsertion.
+    TraceScope reinsertion_trace(config.tracer, "SplitReinsertion");
     for (Node customer : customers) 
     {
         SplitReinsertion(problem, customer, problem.demands[customer], config.blink_rate, solution,
@@ -150,47 +321,170 @@ void Perturb(const Problem &problem, const SpecificConfig &config, SpecificSolut
     }
 }
 
-// Measure the elapsed time since the given start time.
-double ElapsedTime(std::chrono::time_point<std::chrono::high_resolution_clock> start_time) 
+// Construct an initial solution, traced as one phase.
+SpecificSolution InitialSolution(const SpecificConfig &config, const Problem &problem)
 {
-    return std::chrono::duration_cast<std::chrono::duration<double>>(
-               std::chrono::high_resolution_clock::now() - start_time)
-        .count();
+    TraceScope trace(config.tracer, "Construct");
+    return Construct(problem);
 }
 
-// Solve the given problem using the specified metaheuristic.
-SpecificSolution SpecificSolver::Solve(const SpecificConfig &config, const Problem &problem) 
+// Debug check that the objective tracked by the route context matches a full recalculation.
+void CheckObjective(const Problem &problem, const SpecificSolution &solution, const RouteContext &context)
 {
-    if (config.listener != nullptr) config.listener->OnStart(); // Notify start.
+    int objective = solution.CalcObjective(problem);
+    if (context.Objective() != objective)
+    {
+        throw std::logic_error("Tracked objective " + std::to_string(context.Objective())
+                               + " differs from recalculated objective " + std::to_string(objective));
+    }
+}
+
+// Best solution found so far, shared by all search threads.
+struct Incumbent
+{
+    std::mutex mutex;
+    SolutionSnapshot snapshot; // Routes of the best solution
+    std::atomic<int> objective{std::numeric_limits<int>::max()};
+};
+
+// Publish a solution if it improves the incumbent. The listener is notified under the same lock.
+void Publish(const SpecificConfig &config, const SpecificSolution &solution, int objective,
+             Incumbent &incumbent, StoppingCondition &stopping)
+{
+    if (objective >= incumbent.objective.load(std::memory_order_relaxed)) return;
+
+    std::lock_guard<std::mutex> lock(incumbent.mutex);
+    if (objective >= incumbent.objective.load(std::memory_order_relaxed)) return;
+
+    incumbent.snapshot.Capture(solution);
+    incumbent.objective.store(objective, std::memory_order_relaxed);
+    stopping.OnImproved(objective);
+    if (config.listener != nullptr)
+        config.listener->OnUpdated(solution, objective);
+}
+
+// Search state of one perturbation trial of the speculative search.
+struct Trial
+{
+    explicit Trial(const Problem &problem) : context(problem) {}
 
+    SpecificSolution solution; // Perturbed and improved copy of the accepted solution
     RouteContext context;
     CacheMap cache_map;
-    SpecificSolution best_solution;
-    int best_objective = std::numeric_limits<int>::max();
-    auto start_time = std::chrono::high_resolution_clock::now();
-    const int kMaxStagnation = std::min(5000, static_cast<int>(problem.num_customers)
-                                                  * static_cast<int>(CalcFleetLowerBound(problem)));
+};
+
+// One restart of the iterated local search that tries every perturbation on a copy of the accepted
+// solution, one copy per trial. The trials run on the pool with their own random streams, and the
+// best of them goes to the acceptance rule.
+void SpeculativeRestart(const SpecificConfig &config, const Problem &problem, const Rankings &rankings,
+                        const SearchContext &search, StoppingCondition &stopping, int max_stagnation, ThreadPool &pool, vector<std::unique_ptr<Trial>> &trials,
+                        Incumbent &incumbent)
+{
+    auto solution = InitialSolution(config, problem); // Create an initial solution.
+    int objective = solution.CalcObjective(problem);
+    int iter_best_objective = objective;
+    auto acceptance_rule = config.acceptance_rule();
+    int num_stagnation = 0;
+    bool perturb = false; // The initial solution is improved once before it is perturbed.
+
+    while (num_stagnation < max_stagnation && !stopping.ShouldStop()) 
+    {
+        ++num_stagnation;
+        size_t num_trials = perturb ? trials.size() : 1;
+        DeterministicParallelFor(pool, num_trials, [&](size_t i)
+        {
+            Trial &trial = *trials[i];
+            trial.solution = solution;
+            if (perturb) Perturb(problem, config, rankings, trial.solution, trial.context);
+            LocalSearch(problem, config, trial.solution, trial.context, trial.cache_map, search);
+        });
+        perturb = true;
+        stopping.AddIteration();
+
+        // Ties go to the first trial, so the choice does not depend on the timing of the threads.
+        Trial *best = trials[0].get();
+        for (size_t i = 1; i < num_trials; ++i)
+        {
+            if (trials[i]->context.Objective() < best->context.Objective()) best = trials[i].get();
+        }
+
+        int new_objective = best->context.Objective();
+        if (config.check_objective) CheckObjective(problem, best->solution, best->context);
+
+        // Update best solutions if improvements are found.
+        if (new_objective < iter_best_objective) 
+        {
+            num_stagnation = 0;
+            iter_best_objective = new_objective;
+        }
+
+        Publish(config, best->solution, new_objective, incumbent, stopping);
+
+        // Decide whether to continue from the best trial.
+        bool accepted = acceptance_rule->Accept(objective, new_objective);
+        if (config.tracer) config.tracer->Instant(accepted ? "Accept" : "Reject");
+        if (accepted) 
+        {
+            objective = new_objective;
+            std::swap(solution, best->solution);
+        }
+    }
+
+    if (num_stagnation >= max_stagnation) stopping.AddRestart();
+}
+
+// Independent restarts of the iterated local search, run by each search thread.
+void MultiStartSearch(const SpecificConfig &config, const Problem &problem,
+                      const NeighborLists &neighbors, const Rankings &rankings, StoppingCondition &stopping, int thread_index, Incumbent &incumbent, StatisticsRecorder *statistics)
+{
+    ThreadRandom().Seed(config.random_seed, thread_index); // Every thread has its own stream.
+
+    RouteContext context(problem);
+    CacheMap cache_map;
+
+    // Perturbation trials run on a pool of this thread. Without trials, the routes and route pairs
+    // may be searched on it instead. Without a pool everything runs inline.
+    std::unique_ptr<ThreadPool> pool;
+    vector<std::unique_ptr<Trial>> trials;
+    if (config.num_trials > 1)
+    {
+        pool = std::make_unique<ThreadPool>(config.num_trials);
+        for (int i = 0; i < config.num_trials; ++i)
+            trials.push_back(std::make_unique<Trial>(problem));
+    }
+    else if (config.num_evaluation_threads > 1)
+        pool = std::make_unique<ThreadPool>(config.num_evaluation_threads);
+    // The trials take up the pool, so they search sequentially.
+    SearchContext search{neighbors, trials.empty() ? pool.get() : nullptr, statistics, &stopping};
+    const int kMaxStagnation = config.max_stagnation > 0
+        ? config.max_stagnation
+        : std::min(5000, static_cast<int>(problem.num_customers) * static_cast<int>(CalcFleetLowerBound(problem)));
 
-    while (ElapsedTime(start_time) < config.time_limit) 
+    while (!stopping.ShouldStop()) 
     {
-        auto solution = Construct(problem); // Create an initial solution.
+        if (!trials.empty())
+        {
+            SpeculativeRestart(config, problem, rankings, search, stopping, kMaxStagnation, *pool, trials, incumbent);
+            continue;
+        }
+
+        // The search works on a single solution. Every trial is journaled from a checkpoint
+        // of the accepted solution and rolled back if the acceptance rule rejects it.
+        auto solution = InitialSolution(config, problem); // Create an initial solution.
         int objective = solution.CalcObjective(problem);
         int iter_best_objective = objective;
-        auto new_solution = solution;
+        solution.Checkpoint();
         auto acceptance_rule = config.acceptance_rule();
         int num_stagnation = 0;
 
-        while (num_stagnation < kMaxStagnation && ElapsedTime(start_time) < config.time_limit) 
+        while (num_stagnation < kMaxStagnation && !stopping.ShouldStop()) 
         {
             ++num_stagnation;
-            context.CalcRouteContext(new_solution);
+            LocalSearch(problem, config, solution, context, cache_map, search);
+            stopping.AddIteration();
 
-            for (Node i = 0; i < context.NumRoutes(); ++i)
-                IntraRouteSearch(problem, config, i, new_solution, context); // Improve routes.
-
-            RandomizedVariableNeighborhoodDescent(problem, config, new_solution, context, cache_map);
-
-            int new_objective = new_solution.CalcObjective(problem);
+            int new_objective = context.Objective();
+            if (config.check_objective) CheckObjective(problem, solution, context);
 
             // Update best solutions if improvements are found.
             if (new_objective < iter_best_objective) 
@@ -199,28 +493,93 @@ SpecificSolution SpecificSolver::Solve(const SpecificConfig &config, const Probl
                 iter_best_objective = new_objective;
             }
 
-            if (new_objective < best_objective) 
-            {
-                best_objective = new_objective;
-                best_solution = new_solution;
-                if (config.listener != nullptr)
-                    config.listener->OnUpdated(best_solution, best_objective);
-            }
+            Publish(config, solution, new_objective, incumbent, stopping);
 
             // Decide whether to accept the new solution.
-            if (acceptance_rule->Accept(objective, new_objective)) 
+            bool accepted = acceptance_rule->Accept(objective, new_objective);
+            if (config.tracer) config.tracer->Instant(accepted ? "Accept" : "Reject");
+            if (accepted) 
             {
                 objective = new_objective;
-                solution = new_solution;
+                solution.Commit();
             } 
             else
-                new_solution = solution;
+                solution.Rollback();
 
-            Perturb(problem, config, new_solution, context); // Perturb the solution.
+            solution.Checkpoint();
+            Perturb(problem, config, rankings, solution, context); // Perturb the solution.
         }
+
+        if (num_stagnation >= kMaxStagnation) stopping.AddRestart();
     }
+
+    if (statistics)
+    {
+        statistics->AddCaches(cache_map.Statistics());
+        for (auto &trial : trials)
+            statistics->AddCaches(trial->cache_map.Statistics());
+    }
+}
+
+// Solve the given problem using the specified metaheuristic.
+SpecificSolution SpecificSolver::Solve(const SpecificConfig &config, const Problem &problem) 
+{
+    if (config.listener != nullptr) config.listener->OnStart(); // Notify start.
+
+    Incumbent incumbent;
+    NeighborLists neighbors(problem, config.granular_neighbors); // Shared by all search threads.
+    Rankings rankings(problem, config.ruin_neighbors); // Shared by all perturbations.
+    StoppingCondition stopping(config.stopping_criteria, config.time_limit, config.cancellation);
+
+    std::unique_ptr<StatisticsRecorder> statistics;
+    if (config.collect_statistics)
+    {
+        statistics = std::make_unique<StatisticsRecorder>(config.inter_operators.size(),
+                                                          config.intra_operators.size());
+    }
+
+    // A search that fails, e.g. on a failed objective check, cancels the others. The first failure is
+    // rethrown once every thread has stopped.
+    std::exception_ptr failure;
+    std::mutex failure_mutex;
+    auto search = [&](int thread_index)
+    {
+        try
+        {
+            MultiStartSearch(config, problem, neighbors, rankings, stopping, thread_index, incumbent,
+                             statistics.get());
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(failure_mutex);
+            if (!failure) failure = std::current_exception();
+            stopping.Cancel();
+        }
+    };
+
+    // The calling thread runs one of the searches itself.
+    std::vector<std::thread> threads;
+    for (int i = 1; i < config.num_threads; ++i)
+        threads.emplace_back(search, i);
+
+    search(0);
+
+    for (auto &thread : threads)
+        thread.join();
+    if (failure) std::rethrow_exception(failure);
     
-    if (config.listener != nullptr) config.listener->OnEnd(best_solution, best_objective); // Notify end.
+    auto solution = incumbent.snapshot.Restore();
+    if (config.listener != nullptr && statistics)
+    {
+        SearchStatistics search_statistics = statistics->Statistics();
+        for (size_t i = 0; i < config.inter_operators.size(); ++i)
+            search_statistics.inter_operators[i].name = config.inter_operators[i]->Name();
+        for (size_t i = 0; i < config.intra_operators.size(); ++i)
+            search_statistics.intra_operators[i].name = config.intra_operators[i]->Name();
+        config.listener->OnStatistics(search_statistics);
+    }
+    if (config.listener != nullptr)
+        config.listener->OnEnd(solution, incumbent.objective); // Notify end.
 
-    return best_solution; // Return the best solution found.
+    return solution; // Return the best solution found.
 }
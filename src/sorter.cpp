@@ -1,7 +1,12 @@
 #include "../include/sorter.h"
 
 #include <algorithm>
-#include <random>
+
+#include "../include/random_engine.h"
+#include "../include/utils.h"
+
+// Merge buffer of the sorts, kept by every thread
+static thread_local std::vector<Node> sort_buffer;
 
 // Add a sort function with its weight to the sorter.
 void Sorter::AddSortFunction(std::unique_ptr<SortOperator> &&sort_function, double weight)
@@ -11,10 +16,10 @@ void Sorter::AddSortFunction(std::unique_ptr<SortOperator> &&sort_function, doub
 }
 
 // Sort customers using a randomly selected sort function based on weights.
-void Sorter::Sort(const Problem &problem, std::vector<Node> &customers) const
+void Sorter::Sort(const Problem &problem, const Rankings &rankings, std::vector<Node> &customers) const
 {
     // Generate a random number within the sum of weights.
-    double r = static_cast<float>(rand()) / static_cast<float>(RAND_MAX) * sum_weights_;
+    double r = ThreadRandom().Uniform() * sum_weights_;
     
     // Iterate through the sort functions to find which one to apply.
     for (auto &&[sort_function, weight] : sort_functions_)
@@ -23,7 +28,7 @@ void Sorter::Sort(const Problem &problem, std::vector<Node> &customers) const
         if (r < 0)
         {
             // Apply the selected sort function.
-            (*sort_function)(problem, customers);
+            (*sort_function)(problem, rankings, customers);
             return;
         }
     }
@@ -31,30 +36,31 @@ void Sorter::Sort(const Problem &problem, std::vector<Node> &customers) const
 
 // Randomly shuffle the list of customers.
 void SortByRandom::operator()([[maybe_unused]] const Problem &problem,
-                              std::vector<Node> &customers) const
+                              [[maybe_unused]] const Rankings &rankings, std::vector<Node> &customers) const
 {
-    std::random_device rd; // Seed for randomness.
-    std::mt19937 gen(rd()); // Random number generator.
-    shuffle(customers.begin(), customers.end(), gen); // Shuffle the customers.
+    shuffle(customers.begin(), customers.end(), ThreadRandom()); // Shuffle the customers.
 }
 
-// Sort customers by demand in descending order.
-void SortByDemand::operator()(const Problem &problem, std::vector<Node> &customers) const
+// Sort customers by demand in descending order, comparing their precomputed ranks.
+void SortByDemand::operator()([[maybe_unused]] const Problem &problem, const Rankings &rankings,
+                              std::vector<Node> &customers) const
 {
-    std::stable_sort(customers.begin(), customers.end(), [&](Node lhs, Node rhs)
-                     { return problem.demands[lhs] > problem.demands[rhs]; });
+    StableSort(customers, sort_buffer, [&](Node lhs, Node rhs)
+               { return rankings.DemandRank(lhs) > rankings.DemandRank(rhs); });
 }
 
 // Sort customers by distance from the depot (farthest first).
-void SortByFar::operator()(const Problem &problem, std::vector<Node> &customers) const
+void SortByFar::operator()([[maybe_unused]] const Problem &problem, const Rankings &rankings,
+                           std::vector<Node> &customers) const
 {
-    std::stable_sort(customers.begin(), customers.end(), [&](Node lhs, Node rhs)
-                     { return problem.distance_matrix[0][lhs] > problem.distance_matrix[0][rhs]; });
+    StableSort(customers, sort_buffer, [&](Node lhs, Node rhs)
+               { return rankings.DepotDistanceRank(lhs) > rankings.DepotDistanceRank(rhs); });
 }
 
 // Sort customers by distance from the depot (closest first).
-void SortByClose::operator()(const Problem &problem, std::vector<Node> &customers) const
+void SortByClose::operator()([[maybe_unused]] const Problem &problem, const Rankings &rankings,
+                             std::vector<Node> &customers) const
 {
-    std::stable_sort(customers.begin(), customers.end(), [&](Node lhs, Node rhs)
-                     { return problem.distance_matrix[0][lhs] < problem.distance_matrix[0][rhs]; });
+    StableSort(customers, sort_buffer, [&](Node lhs, Node rhs)
+               { return rankings.DepotDistanceRank(lhs) < rankings.DepotDistanceRank(rhs); });
 }
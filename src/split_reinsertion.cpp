@@ -1,4 +1,5 @@
 #include "../include/split_reinsertion.h"
+#include "../include/random_engine.h"
 #include "../include/utils.h"
 #include <algorithm>
 #include <vector>
@@ -18,13 +19,15 @@ void SplitReinsertion(const Problem& problem, Node customer, int demand, double
     auto func = [&](Node predecessor, Node successor, Node customer) {
         Node preCustomer = solution.Customer(predecessor);
         Node sucCustomer = solution.Customer(successor);
-        return problem.distance_matrix[customer][preCustomer]
-               + problem.distance_matrix[customer][sucCustomer]
-               - problem.distance_matrix[preCustomer][sucCustomer];
+        return problem.distance_matrix(customer, preCustomer)
+               + problem.distance_matrix(customer, sucCustomer)
+               - problem.distance_matrix(preCustomer, sucCustomer);
     };
 
-    std::vector<SplitReinsertionMove> moves; // Store possible moves.
-    moves.reserve(context.NumRoutes());
+    // Possible moves, in buffers of the calling thread reused by every reinsertion.
+    static thread_local std::vector<SplitReinsertionMove> moves;
+    static thread_local std::vector<SplitReinsertionMove> sort_buffer;
+    moves.clear();
     int sumResidual = 0;
 
     // Evaluate all routes for potential insertion.
@@ -43,18 +46,18 @@ void SplitReinsertion(const Problem& problem, Node customer, int demand, double
     }
 
     // Sort moves by cost efficiency (scaled by residual capacity).
-    std::stable_sort(moves.begin(), moves.end(),
-                     [](const SplitReinsertionMove& lhs, const SplitReinsertionMove& rhs) {
-                         return lhs.insertion.cost.value * rhs.residual
-                                < rhs.insertion.cost.value * lhs.residual;
-                     });
+    StableSort(moves, sort_buffer,
+               [](const SplitReinsertionMove& lhs, const SplitReinsertionMove& rhs) {
+                   return lhs.insertion.cost.value * rhs.residual
+                          < rhs.insertion.cost.value * lhs.residual;
+               });
 
     // Perform the split reinsertion based on the sorted moves.
     for (const auto& move : moves) {
         sumResidual -= move.residual;
 
         // Randomly skip some moves based on blink_rate.
-        if (sumResidual >= demand && rand() < blink_rate) {
+        if (sumResidual >= demand && ThreadRandom().Uniform() < blink_rate) {
             continue;
         }
 
@@ -67,7 +70,8 @@ void SplitReinsertion(const Problem& problem, Node customer, int demand, double
             context.SetHead(move.insertion.route_index, nodeIndex);
         }
 
-        // Update route context after the insertion.
+        // Update route context after the insertion, sizing it for the new node.
+        context.ResizeNodes(solution);
         context.UpdateRouteContext(solution, move.insertion.route_index, move.insertion.predecessor);
 
         // Decrease the remaining demand.
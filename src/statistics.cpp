@@ -0,0 +1,89 @@
+#include "../include/statistics.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+// Demangle the name of the type if possible
+std::string TypeName(const std::type_info &type)
+{
+#if defined(__GNUG__)
+    int status = 0;
+    std::unique_ptr<char, void (*)(void *)> name(abi::__cxa_demangle(type.name(), nullptr, nullptr, &status),
+                                                 std::free);
+    if (status == 0)
+        return name.get();
+#endif
+    return type.name();
+}
+
+StatisticsRecorder::StatisticsRecorder(size_t num_inter_operators, size_t num_intra_operators)
+    : inter_operators_(num_inter_operators), intra_operators_(num_intra_operators)
+{
+}
+
+void StatisticsRecorder::RecordInter(size_t index, uint64_t nanoseconds, int improvement)
+{
+    Record(inter_operators_[index], nanoseconds, improvement);
+}
+
+void StatisticsRecorder::RecordIntra(size_t index, uint64_t nanoseconds, int improvement)
+{
+    Record(intra_operators_[index], nanoseconds, improvement);
+}
+
+// The counters are independent, so relaxed increments suffice
+void StatisticsRecorder::Record(Counters &counters, uint64_t nanoseconds, int improvement)
+{
+    counters.num_calls.fetch_add(1, std::memory_order_relaxed);
+    counters.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    if (improvement > 0)
+    {
+        counters.num_improvements.fetch_add(1, std::memory_order_relaxed);
+        counters.total_improvement.fetch_add(improvement, std::memory_order_relaxed);
+    }
+}
+
+void StatisticsRecorder::AddCaches(const std::vector<CacheStatistics> &caches)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const CacheStatistics &cache : caches)
+    {
+        auto it = std::find_if(caches_.begin(), caches_.end(),
+                               [&](const CacheStatistics &other) { return other.name == cache.name; });
+        if (it == caches_.end())
+        {
+            caches_.push_back(cache);
+            continue;
+        }
+        it->hits += cache.hits;
+        it->misses += cache.misses;
+    }
+}
+
+OperatorStatistics StatisticsRecorder::Snapshot(const Counters &counters)
+{
+    OperatorStatistics statistics;
+    statistics.num_calls = counters.num_calls.load(std::memory_order_relaxed);
+    statistics.num_improvements = counters.num_improvements.load(std::memory_order_relaxed);
+    statistics.total_improvement = counters.total_improvement.load(std::memory_order_relaxed);
+    statistics.nanoseconds = counters.nanoseconds.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+SearchStatistics StatisticsRecorder::Statistics() const
+{
+    SearchStatistics statistics;
+    for (const Counters &counters : inter_operators_)
+        statistics.inter_operators.push_back(Snapshot(counters));
+    for (const Counters &counters : intra_operators_)
+        statistics.intra_operators.push_back(Snapshot(counters));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    statistics.caches = caches_;
+    return statistics;
+}
@@ -0,0 +1,65 @@
+#include "../include/stopping.h"
+
+#include <limits>
+#include <stdexcept>
+
+StoppingCondition::StoppingCondition(const StoppingCriteria &criteria, double time_limit,
+                                     const CancellationToken *token)
+    : criteria_(criteria), time_limit_(time_limit), token_(token), start_time_(std::chrono::steady_clock::now()),
+      best_objective_(std::numeric_limits<int>::max())
+{
+    bool other_limits = criteria.max_iterations > 0 || criteria.max_restarts > 0 || criteria.max_evaluations > 0
+                        || criteria.target_objective > 0 || criteria.max_iterations_without_improvement > 0;
+    if (time_limit <= 0 && !other_limits && token == nullptr)
+        throw std::invalid_argument("The search has no stopping criterion.");
+
+    // With require_all the time limit stops the search only together with the other limits
+    has_deadline_ = time_limit > 0 && !(criteria.require_all && other_limits);
+    if (has_deadline_)
+    {
+        deadline_ = start_time_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                      std::chrono::duration<double>(time_limit));
+    }
+}
+
+void StoppingCondition::OnImproved(int objective)
+{
+    best_objective_.store(objective, std::memory_order_relaxed);
+    last_improvement_.store(num_iterations_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+bool StoppingCondition::ShouldStop()
+{
+    if (IsCancelled())
+        return true;
+
+    uint64_t num_iterations = num_iterations_.load(std::memory_order_relaxed);
+    int num_set = 0;
+    int num_reached = 0;
+    auto check = [&](bool set, bool reached)
+    {
+        num_set += set;
+        num_reached += set && reached;
+    };
+    check(time_limit_ > 0, ElapsedSeconds() >= time_limit_);
+    check(criteria_.max_iterations > 0, num_iterations >= criteria_.max_iterations);
+    check(criteria_.max_restarts > 0, num_restarts_.load(std::memory_order_relaxed) >= criteria_.max_restarts);
+    check(criteria_.max_evaluations > 0,
+          num_evaluations_.load(std::memory_order_relaxed) >= criteria_.max_evaluations);
+    check(criteria_.target_objective > 0,
+          best_objective_.load(std::memory_order_relaxed) <= criteria_.target_objective);
+    check(criteria_.max_iterations_without_improvement > 0,
+          num_iterations - last_improvement_.load(std::memory_order_relaxed)
+              >= criteria_.max_iterations_without_improvement);
+
+    if (num_set == 0 || num_reached < (criteria_.require_all ? num_set : 1))
+        return false;
+
+    stopped_.Cancel();
+    return true;
+}
+
+double StoppingCondition::ElapsedSeconds() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+}
@@ -0,0 +1,133 @@
+#include "../include/thread_pool.h"
+
+#include <algorithm>
+
+// Start the workers
+ThreadPool::ThreadPool(int num_threads)
+{
+    num_threads = std::max(num_threads, 1);
+    for (int i = 0; i < num_threads; ++i)
+        queues_.push_back(std::make_unique<Queue>());
+
+    for (int i = 1; i < num_threads; ++i)
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+// Stop and join the workers
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_.notify_all();
+
+    for (auto &worker : workers_)
+        worker.join();
+}
+
+// Split the range into chunks, deal them to the queues and work until all indices are done
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)> &function)
+{
+    if (count == 0)
+        return;
+
+    if (workers_.empty())
+    {
+        for (size_t i = 0; i < count; ++i)
+            function(i);
+        return;
+    }
+
+    // A few chunks per thread leave room for stealing when the calls take uneven time
+    size_t num_chunks = std::min(count, queues_.size() * 4);
+    size_t chunk_size = (count + num_chunks - 1) / num_chunks;
+
+    function_ = &function;
+    remaining_.store(count);
+    size_t thread_index = 0;
+    for (size_t first = 0; first < count; first += chunk_size)
+    {
+        Queue &queue = *queues_[thread_index];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.chunks.emplace_back(first, std::min(first + chunk_size, count));
+        }
+        thread_index = (thread_index + 1) % queues_.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+    }
+    start_.notify_all();
+
+    Work(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this]() { return remaining_.load() == 0; });
+    function_ = nullptr;
+}
+
+// Take a chunk from the back of the own queue, or steal one from the front of another queue
+bool ThreadPool::Pop(int thread_index, Chunk &chunk)
+{
+    {
+        Queue &queue = *queues_[thread_index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.chunks.empty())
+        {
+            chunk = queue.chunks.back();
+            queue.chunks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < queues_.size(); ++offset)
+    {
+        Queue &queue = *queues_[(thread_index + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.chunks.empty())
+        {
+            chunk = queue.chunks.front();
+            queue.chunks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Run chunks until every queue is empty
+void ThreadPool::Work(int thread_index)
+{
+    Chunk chunk;
+    while (Pop(thread_index, chunk))
+    {
+        for (size_t i = chunk.first; i < chunk.second; ++i)
+            (*function_)(i);
+
+        // The last chunk wakes the caller
+        if (remaining_.fetch_sub(chunk.second - chunk.first) == chunk.second - chunk.first)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_.notify_all();
+        }
+    }
+}
+
+// Wait for a new loop, take part in it, and repeat until the pool is destroyed
+void ThreadPool::WorkerLoop(int thread_index)
+{
+    size_t generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [&]() { return stop_ || generation_ != generation; });
+            if (stop_)
+                return;
+            generation = generation_;
+        }
+        Work(thread_index);
+    }
+}
@@ -0,0 +1,125 @@
+#include "../include/tracer.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+std::atomic<uint64_t> next_tracer_id{1};
+
+// Buffer of the calling thread in the tracer with the given id. A thread records to one tracer at
+// a time, so a single slot suffices, and the id keeps a new tracer from reusing a stale buffer.
+struct ThreadSlot
+{
+    uint64_t tracer_id = 0;
+    void *buffer = nullptr;
+};
+thread_local ThreadSlot thread_slot;
+
+// Write the name as a JSON string
+void WriteString(std::ostream &os, const char *name)
+{
+    os << '"';
+    for (const char *c = name; *c; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+            os << '\\';
+        os << *c;
+    }
+    os << '"';
+}
+
+// Write nanoseconds as microseconds with three decimals, the unit of the trace-event format
+void WriteMicroseconds(std::ostream &os, uint64_t nanoseconds)
+{
+    os << nanoseconds / 1000 << '.' << nanoseconds / 100 % 10 << nanoseconds / 10 % 10 << nanoseconds % 10;
+}
+}
+
+Tracer::Tracer(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)), id_(next_tracer_id++), start_time_(std::chrono::steady_clock::now())
+{
+}
+
+void Tracer::Complete(const char *name, std::chrono::steady_clock::time_point start_time)
+{
+    uint64_t start = Nanoseconds(start_time);
+    Record(name, start, Nanoseconds(std::chrono::steady_clock::now()) - start, 'X');
+}
+
+void Tracer::Instant(const char *name)
+{
+    Record(name, Nanoseconds(std::chrono::steady_clock::now()), 0, 'i');
+}
+
+const char *Tracer::Intern(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &interned = names_[name];
+    if (!interned)
+        interned = std::make_unique<std::string>(name);
+    return interned->c_str();
+}
+
+// Only the owning thread writes to a buffer, so recording takes no lock
+void Tracer::Record(const char *name, uint64_t start, uint64_t duration, char phase)
+{
+    Buffer &buffer = ThreadBuffer();
+    buffer.events[buffer.num_recorded % capacity_] = {name, start, duration, phase};
+    ++buffer.num_recorded;
+}
+
+Tracer::Buffer &Tracer::ThreadBuffer()
+{
+    if (thread_slot.tracer_id == id_)
+        return *static_cast<Buffer *>(thread_slot.buffer);
+
+    auto buffer = std::make_unique<Buffer>();
+    buffer->events.resize(capacity_);
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer->thread_index = static_cast<int>(buffers_.size());
+    thread_slot = {id_, buffer.get()};
+    buffers_.push_back(std::move(buffer));
+    return *buffers_.back();
+}
+
+uint64_t Tracer::Nanoseconds(std::chrono::steady_clock::time_point time) const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - start_time_).count();
+}
+
+// Events of each thread are written oldest first, with timestamps in microseconds
+void Tracer::WriteChromeTrace(std::ostream &os) const
+{
+    uint64_t num_dropped = 0;
+    bool first = true;
+    os << "{\"traceEvents\":[";
+    for (const auto &buffer : buffers_)
+    {
+        uint64_t num_kept = std::min<uint64_t>(buffer->num_recorded, capacity_);
+        num_dropped += buffer->num_recorded - num_kept;
+
+        os << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+           << buffer->thread_index << ",\"args\":{\"name\":\"Thread " << buffer->thread_index << "\"}}";
+        first = false;
+
+        for (uint64_t i = buffer->num_recorded - num_kept; i < buffer->num_recorded; ++i)
+        {
+            const Event &event = buffer->events[i % capacity_];
+            os << ",\n{\"name\":";
+            WriteString(os, event.name);
+            os << ",\"ph\":\"" << event.phase << "\",\"pid\":1,\"tid\":" << buffer->thread_index
+               << ",\"ts\":";
+            WriteMicroseconds(os, event.start);
+            if (event.phase == 'X')
+            {
+                os << ",\"dur\":";
+                WriteMicroseconds(os, event.duration);
+            }
+            else
+                os << ",\"s\":\"t\"";
+            os << '}';
+        }
+    }
+    os << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":" << num_dropped << "}}\n";
+}